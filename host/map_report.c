@@ -0,0 +1,315 @@
+/************************************************************************************//**
+* \file     map_report.c
+* \brief    Reference host report of flash and SRAM used by every module of the DAQ.
+*
+*           Build: cc -std=c99 -O2 -o map_report map_report.c
+*           Usage: map_report [map file]
+*           Linker map (Debug/Daq.map, written by every build) is read from file or
+*           standard input. Bytes of input sections placed in flash (.text, .ARM.exidx,
+*           initial values of .relocate) and SRAM (.relocate, .bss, .stack) are summed
+*           per object file, objects of a library count as the library. Table is sorted
+*           by SRAM, then flash, and ends with totals and sizes of the memory regions.
+*           Stack reserved by linker script and alignment fill have their own rows.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>                   /* Standard I/O functions.                        */
+#include <stdint.h>                  /* Standard integer types                         */
+#include <stdlib.h>                  /* Standard library                               */
+#include <string.h>                  /* String functions                               */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Longest line of map file */
+#define MAX_LINE            1024
+/** \brief Longest module name */
+#define MAX_NAME            64
+/** \brief Most modules */
+#define MAX_MODULES         512
+
+/* Placement of output section */
+/** \brief Not loaded to target */
+#define PLACE_NONE          0
+/** \brief Flash only */
+#define PLACE_FLASH         1
+/** \brief SRAM only */
+#define PLACE_RAM           2
+/** \brief SRAM, initial values in flash */
+#define PLACE_BOTH          3
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Memory used by one module */
+typedef struct
+{
+  char name[MAX_NAME];               /* Object or library file name                    */
+  uint32_t flash;                    /* Bytes in flash                                 */
+  uint32_t ram;                      /* Bytes in SRAM                                  */
+}module_t;
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Modules in order they were found. */
+static module_t modules[MAX_MODULES];
+/** \brief Number of modules. */
+static int moduleCount = 0;
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static int sectionPlace(const char *name);
+static void addBytes(const char *file, int place, uint32_t size);
+static int compareModules(const void *a, const void *b);
+
+
+/****************************************************************************************
+*                                R E P O R T   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Gets placement of output section of the linker script.
+** \param     name Output section name.
+** \return    PLACE_NONE, PLACE_FLASH, PLACE_RAM or PLACE_BOTH.
+**
+****************************************************************************************/
+static int sectionPlace(const char *name)
+{
+  if(!strcmp(name, ".text") || !strcmp(name, ".ARM.exidx"))
+  {
+    return PLACE_FLASH;
+  }
+  if(!strcmp(name, ".relocate"))
+  {
+    return PLACE_BOTH;
+  }
+  if(!strcmp(name, ".bss") || !strcmp(name, ".stack"))
+  {
+    return PLACE_RAM;
+  }
+  return PLACE_NONE;
+} /*** end of sectionPlace ***/
+
+/************************************************************************************//**
+** \brief     Adds bytes to the module of object file.
+** \param     file Object file path as written in map, or name of a row.
+** \param     place Placement of output section.
+** \param     size Number of bytes.
+**
+****************************************************************************************/
+static void addBytes(const char *file, int place, uint32_t size)
+{
+  char name[MAX_NAME];
+  const char *start = file;
+  const char *end;
+  int i;
+
+  /* Library member "path/lib.a(member.o)" counts as the library. */
+  end = file + strlen(file);
+  if((end > file) && (end[-1] == ')') && (strrchr(file, '(') != NULL))
+  {
+    end = strrchr(file, '(');
+  }
+  for(const char *c = file; c < end; c++)
+  {
+    if((*c == '/') || (*c == '\\'))
+    {
+      start = c + 1;
+    }
+  }
+  snprintf(name, sizeof(name), "%.*s", (int)(end - start), start);
+
+  for(i = 0; i < moduleCount; i++)
+  {
+    if(!strcmp(modules[i].name, name))
+    {
+      break;
+    }
+  }
+  if(i == moduleCount)
+  {
+    if(moduleCount >= MAX_MODULES)
+    {
+      return;
+    }
+    strcpy(modules[i].name, name);
+    modules[i].flash = 0;
+    modules[i].ram = 0;
+    moduleCount++;
+  }
+  if(place & PLACE_FLASH)
+  {
+    modules[i].flash += size;
+  }
+  if(place & PLACE_RAM)
+  {
+    modules[i].ram += size;
+  }
+} /*** end of addBytes ***/
+
+/************************************************************************************//**
+** \brief     Orders modules by SRAM, then flash, largest first.
+** \param     a First module.
+** \param     b Second module.
+** \return    Negative if a goes first, positive if b goes first.
+**
+****************************************************************************************/
+static int compareModules(const void *a, const void *b)
+{
+  const module_t *ma = (const module_t *)a;
+  const module_t *mb = (const module_t *)b;
+
+  if(ma->ram != mb->ram)
+  {
+    return (ma->ram < mb->ram) ? 1 : -1;
+  }
+  if(ma->flash != mb->flash)
+  {
+    return (ma->flash < mb->flash) ? 1 : -1;
+  }
+  return strcmp(ma->name, mb->name);
+} /*** end of compareModules ***/
+
+
+/************************************************************************************//**
+** \brief     Reads linker map and writes memory used by every module.
+** \return    Program exit code.
+**
+****************************************************************************************/
+int main(int argc, char *argv[])
+{
+  char line[MAX_LINE];
+  char name[MAX_LINE];
+  char file[MAX_LINE];
+  char section[MAX_LINE] = "";
+  unsigned long addr, size, origin, length;
+  uint32_t sectionSize = 0, sectionUsed = 0;
+  uint32_t flash = 0, ram = 0, totalFlash = 0, totalRam = 0;
+  int place = PLACE_NONE;
+  int inMap = 0;
+  int fields;
+  FILE *f = stdin;
+
+  if((argc > 1) && ((f = fopen(argv[1], "r")) == NULL))
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  while(fgets(line, sizeof(line), f) != NULL)
+  {
+    /* Regions are listed before the map, discarded sections must be skipped. */
+    if(!inMap)
+    {
+      if(sscanf(line, "%s 0x%lx 0x%lx", name, &origin, &length) == 3)
+      {
+        if(!strcmp(name, "rom"))
+        {
+          flash = (uint32_t)length;
+        }
+        else if(!strcmp(name, "ram"))
+        {
+          ram = (uint32_t)length;
+        }
+      }
+      inMap = !strncmp(line, "Linker script and memory map", 28);
+      continue;
+    }
+    /* Output section starts at the first column. */
+    if((line[0] != ' ') && (line[0] != '\n') && (line[0] != '\r'))
+    {
+      /* Bytes which no input section claimed are fill or reserved stack. */
+      if(place != PLACE_NONE && (sectionSize > sectionUsed))
+      {
+        addBytes(strcmp(section, ".stack") ? "[fill]" : "[stack]", place,
+                 sectionSize - sectionUsed);
+      }
+      sectionSize = 0;
+      sectionUsed = 0;
+      fields = sscanf(line, "%s 0x%lx 0x%lx", section, &addr, &size);
+      place = sectionPlace(section);
+      if((place != PLACE_NONE) && (fields < 3))
+      {
+        /* Long name, address and size are on the next line. */
+        if((fgets(line, sizeof(line), f) == NULL) ||
+           (sscanf(line, " 0x%lx 0x%lx", &addr, &size) != 2))
+        {
+          place = PLACE_NONE;
+        }
+      }
+      if(place != PLACE_NONE)
+      {
+        sectionSize = (uint32_t)size;
+        totalFlash += (place & PLACE_FLASH) ? sectionSize : 0;
+        totalRam += (place & PLACE_RAM) ? sectionSize : 0;
+      }
+      continue;
+    }
+    /* Input section is indented by one space, patterns and fill start with '*'. */
+    if((place == PLACE_NONE) || (line[1] == ' ') || (line[1] == '*'))
+    {
+      continue;
+    }
+    /* Paths of the toolchain may contain spaces. */
+    fields = sscanf(line, " %s 0x%lx 0x%lx %[^\r\n]", name, &addr, &size, file);
+    if(fields == 1)
+    {
+      /* Long name, the rest is on the next line. */
+      if(fgets(line, sizeof(line), f) == NULL)
+      {
+        break;
+      }
+      fields = 1 + sscanf(line, " 0x%lx 0x%lx %[^\r\n]", &addr, &size, file);
+    }
+    if((fields == 4) && size)
+    {
+      while(strlen(file) && (file[strlen(file) - 1] == ' '))
+      {
+        file[strlen(file) - 1] = '\0';
+      }
+      addBytes(file, place, (uint32_t)size);
+      sectionUsed += (uint32_t)size;
+    }
+  }
+  if(place != PLACE_NONE && (sectionSize > sectionUsed))
+  {
+    addBytes(strcmp(section, ".stack") ? "[fill]" : "[stack]", place,
+             sectionSize - sectionUsed);
+  }
+  if(f != stdin)
+  {
+    fclose(f);
+  }
+  if(!inMap)
+  {
+    fprintf(stderr, "no memory map found\n");
+    return 1;
+  }
+
+  qsort(modules, moduleCount, sizeof(module_t), compareModules);
+  printf("%-40s %10s %10s\n", "module", "flash", "sram");
+  for(int i = 0; i < moduleCount; i++)
+  {
+    printf("%-40s %10lu %10lu\n", modules[i].name, (unsigned long)modules[i].flash,
+           (unsigned long)modules[i].ram);
+  }
+  printf("%-40s %10lu %10lu\n", "total", (unsigned long)totalFlash,
+         (unsigned long)totalRam);
+  if(flash && ram)
+  {
+    printf("%-40s %10lu %10lu\n", "region", (unsigned long)flash, (unsigned long)ram);
+    printf("%-40s %10ld %10ld\n", "left", (long)flash - (long)totalFlash,
+           (long)ram - (long)totalRam);
+  }
+  return 0;
+} /*** end of main ***/
+
+
+/********************************* end of map_report.c *********************************/
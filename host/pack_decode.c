@@ -0,0 +1,356 @@
+/************************************************************************************//**
+* \file     pack_decode.c
+* \brief    Reference host decoder of packed and compressed BIN frames of the DAQ.
+*
+*           Build: cc -std=c99 -O2 -o pack_decode pack_decode.c
+*           Usage: pack_decode {encoding} {block size} [file]
+*           encoding is parameter of Q command (1 = packed, 2 = compressed), block size
+*           is parameter of B command. Data captured from the port is read from file or
+*           standard input, text before the first frame is skipped. Every row of samples
+*           is written to standard output as codes separated by commas, first line names
+*           the channels.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>                   /* Standard I/O functions.                        */
+#include <stdint.h>                  /* Standard integer types                         */
+#include <stdlib.h>                  /* Standard library                               */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Encoding values, same as in pack.h */
+/** \brief Samples are packed to 12 or 10 bits after frame header */
+#define PACK_ON             1
+/** \brief Deltas are Rice coded, blocks which do not compress are packed */
+#define PACK_RICE           2
+
+/** \brief Frame header of packed frame */
+#define PACK_HEADER_SIZE    4
+/** \brief Frame header of compressed frame */
+#define PACK_RICE_HEADER_SIZE 8
+/** \brief Rice parameters of a block which is packed instead */
+#define PACK_RICE_RAW       0xFFFF
+/** \brief Longest unary quotient, larger deltas are sent as escape and sample */
+#define PACK_RICE_ESCAPE    16
+/** \brief Largest block size */
+#define MAX_BLOCK_SIZE      1024
+/** \brief Largest frame */
+#define MAX_FRAME_SIZE      (PACK_RICE_HEADER_SIZE + MAX_BLOCK_SIZE * 2)
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Bit reader */
+typedef struct
+{
+  const uint8_t *buf;                /* Input bytes                                    */
+  uint32_t len;                      /* Number of input bytes                          */
+  uint32_t pos;                      /* Position of next bit                           */
+}bits_t;
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static int readBit(bits_t *in);
+static uint32_t readBits(bits_t *in, uint8_t count);
+static int unpackSamples(bits_t *in, uint16_t *samples, uint32_t size, uint8_t bits);
+static int decodeRice(bits_t *in, uint16_t *samples, uint32_t size, uint8_t bits,
+                      uint8_t chCount, uint16_t params);
+static int readFrame(FILE *f, int encoding, uint32_t blockSize, uint16_t *samples,
+                     uint8_t *chCount, uint8_t *order);
+
+
+/****************************************************************************************
+*                              D E C O D E R   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Reads one bit, bits are packed LSB first.
+** \param     in Bit reader.
+** \return    Bit value, -1 at the end of input.
+**
+****************************************************************************************/
+static int readBit(bits_t *in)
+{
+  int bit;
+
+  if(in->pos >= in->len * 8)
+  {
+    /* Position past the end marks the error. */
+    in->pos++;
+    return -1;
+  }
+  bit = (in->buf[in->pos / 8] >> (in->pos % 8)) & 1;
+  in->pos++;
+  return bit;
+} /*** end of readBit ***/
+
+/************************************************************************************//**
+** \brief     Reads unsigned value, LSB first.
+** \param     in Bit reader.
+** \param     count Number of bits.
+** \return    Value, bits after the end of input read as 0.
+**
+****************************************************************************************/
+static uint32_t readBits(bits_t *in, uint8_t count)
+{
+  uint32_t val = 0;
+  int bit;
+
+  for(uint8_t i = 0; i < count; i++)
+  {
+    bit = readBit(in);
+    if(bit > 0)
+    {
+      val |= 1u << i;
+    }
+  }
+  return val;
+} /*** end of readBits ***/
+
+/************************************************************************************//**
+** \brief     Unpacks packed samples.
+** \param     in Bit reader.
+** \param     samples Decoded samples.
+** \param     size Number of samples.
+** \param     bits Bits per sample.
+** \return    0 if successful, -1 otherwise.
+**
+****************************************************************************************/
+static int unpackSamples(bits_t *in, uint16_t *samples, uint32_t size, uint8_t bits)
+{
+  if(in->len * 8 < size * bits)
+  {
+    return -1;
+  }
+  for(uint32_t i = 0; i < size; i++)
+  {
+    samples[i] = (uint16_t)readBits(in, bits);
+  }
+  return 0;
+} /*** end of unpackSamples ***/
+
+/************************************************************************************//**
+** \brief     Decodes per channel delta and Rice code, see packRice() in pack.c.
+** \param     in Bit reader.
+** \param     samples Decoded samples.
+** \param     size Number of samples.
+** \param     bits Bits per sample.
+** \param     chCount Number of channels.
+** \param     params Rice parameter of every channel, 4 bits each.
+** \return    0 if successful, -1 otherwise.
+**
+****************************************************************************************/
+static int decodeRice(bits_t *in, uint16_t *samples, uint32_t size, uint8_t bits,
+                      uint8_t chCount, uint16_t params)
+{
+  int32_t prev[4] = {0, 0, 0, 0};
+  uint32_t q, u;
+  uint8_t ch, k;
+  int bit;
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    ch = (uint8_t)(i % chCount);
+    k = (params >> (4 * ch)) & 0x0F;
+    if(i < chCount)
+    {
+      prev[ch] = (int32_t)readBits(in, bits);
+    }
+    else
+    {
+      q = 0;
+      while(q < PACK_RICE_ESCAPE)
+      {
+        bit = readBit(in);
+        if(bit < 0)
+        {
+          return -1;
+        }
+        if(!bit)
+        {
+          break;
+        }
+        q++;
+      }
+      if(q < PACK_RICE_ESCAPE)
+      {
+        u = (q << k) | readBits(in, k);
+        /* Zigzag back to signed difference. */
+        prev[ch] += (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+      }
+      else
+      {
+        prev[ch] = (int32_t)readBits(in, bits);
+      }
+    }
+    if(in->pos > in->len * 8)
+    {
+      return -1;
+    }
+    samples[i] = (uint16_t)prev[ch];
+  }
+  return 0;
+} /*** end of decodeRice ***/
+
+/************************************************************************************//**
+** \brief     Reads and decodes next frame. Bytes are skipped until sync bytes of block
+**            size are found.
+** \param     f Input file.
+** \param     encoding PACK_ON or PACK_RICE.
+** \param     blockSize Number of samples in block.
+** \param     samples Decoded samples.
+** \param     chCount Number of channels.
+** \param     order DAQ channel of every sample in a row.
+** \return    0 if successful, -1 at the end of input. Corrupted frames are skipped.
+**
+****************************************************************************************/
+static int readFrame(FILE *f, int encoding, uint32_t blockSize, uint16_t *samples,
+                     uint8_t *chCount, uint8_t *order)
+{
+  static uint8_t frame[MAX_FRAME_SIZE];
+  uint8_t sync0 = (blockSize & 0x7F) | 0x80;
+  uint8_t sync1 = ((blockSize >> 7) & 0x7F) | 0x80;
+  uint8_t headerSize = PACK_HEADER_SIZE;
+  uint16_t params;
+  uint32_t len;
+  uint8_t bits;
+  bits_t in;
+  int c, prev = -1;
+
+  if(encoding == PACK_RICE)
+  {
+    headerSize = PACK_RICE_HEADER_SIZE;
+  }
+  while(1)
+  {
+    /* Find sync bytes. */
+    while((c = fgetc(f)) != EOF)
+    {
+      if((prev == sync0) && (c == sync1))
+      {
+        break;
+      }
+      prev = c;
+    }
+    if(c == EOF)
+    {
+      return -1;
+    }
+    prev = -1;
+    frame[0] = sync0;
+    frame[1] = sync1;
+    if(fread(&frame[2], 1, headerSize - 2, f) != (size_t)(headerSize - 2))
+    {
+      return -1;
+    }
+    *chCount = frame[2] >> 4;
+    bits = frame[2] & 0x0F;
+    /* Sync bytes were found in data, search again. */
+    if((*chCount < 1) || (*chCount > 4) || ((bits != 12) && (bits != 10)))
+    {
+      continue;
+    }
+    for(uint8_t ch = 0; ch < *chCount; ch++)
+    {
+      order[ch] = ((frame[3] >> (2 * ch)) & 0x03) + 1;
+    }
+    len = (blockSize * bits + 7) / 8;
+    params = PACK_RICE_RAW;
+    if(encoding == PACK_RICE)
+    {
+      params = frame[4] | (frame[5] << 8);
+      len = frame[6] | (frame[7] << 8);
+    }
+    if(len + headerSize > MAX_FRAME_SIZE)
+    {
+      continue;
+    }
+    if(fread(&frame[headerSize], 1, len, f) != len)
+    {
+      return -1;
+    }
+
+    in.buf = &frame[headerSize];
+    in.len = len;
+    in.pos = 0;
+    if(params == PACK_RICE_RAW)
+    {
+      if(unpackSamples(&in, samples, blockSize, bits) == 0)
+      {
+        return 0;
+      }
+    }
+    else if(decodeRice(&in, samples, blockSize, bits, *chCount, params) == 0)
+    {
+      return 0;
+    }
+    fprintf(stderr, "corrupted frame skipped\n");
+  }
+} /*** end of readFrame ***/
+
+
+/************************************************************************************//**
+** \brief     Decodes frames to rows of codes.
+** \return    Program exit code.
+**
+****************************************************************************************/
+int main(int argc, char *argv[])
+{
+  static uint16_t samples[MAX_BLOCK_SIZE];
+  uint8_t order[4];
+  uint8_t chCount;
+  uint32_t blockSize;
+  int encoding;
+  int header = 0;
+  FILE *f = stdin;
+
+  if(argc < 3)
+  {
+    fprintf(stderr, "usage: %s {encoding 1|2} {block size} [file]\n", argv[0]);
+    return 1;
+  }
+  encoding = atoi(argv[1]);
+  blockSize = (uint32_t)atoi(argv[2]);
+  if(((encoding != PACK_ON) && (encoding != PACK_RICE)) ||
+     (blockSize < 1) || (blockSize > MAX_BLOCK_SIZE))
+  {
+    fprintf(stderr, "invalid encoding or block size\n");
+    return 1;
+  }
+  if((argc > 3) && ((f = fopen(argv[3], "rb")) == NULL))
+  {
+    perror(argv[3]);
+    return 1;
+  }
+
+  while(readFrame(f, encoding, blockSize, samples, &chCount, order) == 0)
+  {
+    if(!header)
+    {
+      for(uint8_t ch = 0; ch < chCount; ch++)
+      {
+        printf("%sCH%u", ch ? "," : "", order[ch]);
+      }
+      printf("\n");
+      header = 1;
+    }
+    for(uint32_t i = 0; i < blockSize; i++)
+    {
+      printf("%u%s", samples[i], ((i % chCount) == chCount - 1u) ? "\n" : ",");
+    }
+  }
+  if(f != stdin)
+  {
+    fclose(f);
+  }
+  return 0;
+} /*** end of main ***/
+
+
+/********************************* end of pack_decode.c ********************************/
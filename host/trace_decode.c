@@ -0,0 +1,247 @@
+/************************************************************************************//**
+* \file     trace_decode.c
+* \brief    Reference host decoder of event trace dumps of the DAQ.
+*
+*           Build: cc -std=c99 -O2 -o trace_decode trace_decode.c
+*           Usage: trace_decode [file]
+*           Dumps sent by t command (Debug build) are read from file or standard input,
+*           other bytes are skipped. Events are written to standard output as Chrome
+*           trace event JSON, which chrome://tracing and Perfetto show as a timeline.
+*           Every dump is one process, its events are grouped to ADC, DAC, USB and
+*           event handler threads. Time is in microseconds from the oldest entry.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>                   /* Standard I/O functions.                        */
+#include <stdint.h>                  /* Standard integer types                         */
+#include <stdlib.h>                  /* Standard library                               */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Version of trace dump, same as in trace.h */
+#define TRACE_VERSION       1
+/** \brief Size of dump header */
+#define TRACE_HEADER_SIZE   16
+/** \brief Size of one entry */
+#define TRACE_ENTRY_SIZE    8
+/** \brief Most entries in a dump */
+#define MAX_ENTRIES         4096
+
+/* Threads of the timeline */
+/** \brief ADC interrupt */
+#define THREAD_ADC          1
+/** \brief DACC interrupt */
+#define THREAD_DAC          2
+/** \brief USB interrupt and writing to interfaces */
+#define THREAD_USB          3
+/** \brief Event handlers in PendSV */
+#define THREAD_EVENT        4
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Description of traced event, index is event type of trace.h */
+typedef struct
+{
+  const char *name;                  /* Name on timeline                               */
+  char phase;                        /* 'i' instant, 'B' begin or 'E' end of duration  */
+  uint8_t thread;                    /* Thread of timeline                             */
+}event_desc_t;
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Traced events, same order as in trace.h. */
+static const event_desc_t events[] =
+{
+  {"adcBlock", 'i', THREAD_ADC},
+  {"adcRearm", 'i', THREAD_ADC},
+  {"block", 'B', THREAD_EVENT},
+  {"block", 'E', THREAD_EVENT},
+  {"flush", 'i', THREAD_EVENT},
+  {"txSubmit", 'i', THREAD_USB},
+  {"txDone", 'i', THREAD_USB},
+  {"usbRx", 'i', THREAD_USB},
+  {"command", 'i', THREAD_EVENT},
+  {"dacRepeat", 'i', THREAD_DAC}
+};
+/** \brief Names of threads, index is thread. */
+static const char *threads[] = {"", "ADC", "DAC", "USB", "events"};
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static uint32_t getU32(const uint8_t *buf);
+static int readDump(FILE *f, uint8_t *header, uint8_t *entries);
+static void writeDump(const uint8_t *header, const uint8_t *entries, int pid, int *first);
+
+
+/****************************************************************************************
+*                              D E C O D E R   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Reads little endian 32 bit value.
+** \param     buf Input bytes.
+** \return    Value.
+**
+****************************************************************************************/
+static uint32_t getU32(const uint8_t *buf)
+{
+  return buf[0] | (buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+} /*** end of getU32 ***/
+
+/************************************************************************************//**
+** \brief     Reads next dump. Bytes are skipped until its id and version are found.
+** \param     f Input file.
+** \param     header Dump header.
+** \param     entries Entries as they were stored.
+** \return    0 if successful, -1 at the end of input.
+**
+****************************************************************************************/
+static int readDump(FILE *f, uint8_t *header, uint8_t *entries)
+{
+  uint32_t count;
+  int c, prev = -1;
+
+  while(1)
+  {
+    /* Find id. */
+    while((c = fgetc(f)) != EOF)
+    {
+      if((prev == 'T') && (c == 'R'))
+      {
+        break;
+      }
+      prev = c;
+    }
+    if(c == EOF)
+    {
+      return -1;
+    }
+    prev = -1;
+    header[0] = 'T';
+    header[1] = 'R';
+    if(fread(&header[2], 1, TRACE_HEADER_SIZE - 2, f) != TRACE_HEADER_SIZE - 2)
+    {
+      return -1;
+    }
+    count = header[4] | (header[5] << 8);
+    /* Id was found in other data, search again. */
+    if((header[2] != TRACE_VERSION) || (header[3] != TRACE_ENTRY_SIZE) || !count ||
+       (count > MAX_ENTRIES) || ((uint32_t)(header[6] | (header[7] << 8)) >= count))
+    {
+      continue;
+    }
+    if(fread(entries, TRACE_ENTRY_SIZE, count, f) != count)
+    {
+      return -1;
+    }
+    return 0;
+  }
+} /*** end of readDump ***/
+
+/************************************************************************************//**
+** \brief     Writes events of one dump, oldest first. Cycle counter wraps around, so
+**            time is summed from differences of successive entries.
+** \param     header Dump header.
+** \param     entries Entries as they were stored.
+** \param     pid Process of the dump on timeline.
+** \param     first Set to 0 after the first event was written.
+**
+****************************************************************************************/
+static void writeDump(const uint8_t *header, const uint8_t *entries, int pid, int *first)
+{
+  uint32_t size = header[4] | (header[5] << 8);
+  uint32_t next = header[6] | (header[7] << 8);
+  uint32_t count = getU32(&header[8]);
+  double cpuHz = getU32(&header[12]);
+  uint32_t start = 0;
+  uint32_t prev = 0;
+  uint64_t time = 0;
+  const uint8_t *entry;
+  uint8_t event;
+
+  if(count > size)
+  {
+    /* Entries were overwritten, the oldest one is written next. */
+    start = next;
+    count = size;
+  }
+  if(cpuHz <= 0)
+  {
+    cpuHz = 1e6;
+  }
+  for(uint8_t t = 1; t < sizeof(threads) / sizeof(threads[0]); t++)
+  {
+    printf("%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+           "\"args\":{\"name\":\"%s\"}}", *first ? "" : ",", pid, t, threads[t]);
+    *first = 0;
+  }
+  for(uint32_t i = 0; i < count; i++)
+  {
+    entry = &entries[((start + i) % size) * TRACE_ENTRY_SIZE];
+    if(i)
+    {
+      time += (uint32_t)(getU32(entry) - prev);
+    }
+    prev = getU32(entry);
+    event = entry[4];
+    if(event >= sizeof(events) / sizeof(events[0]))
+    {
+      fprintf(stderr, "unknown event %u skipped\n", event);
+      continue;
+    }
+    printf(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u,"
+           "%s\"args\":{\"par\":%u}}", events[event].name, events[event].phase,
+           time * 1e6 / cpuHz, pid, events[event].thread,
+           (events[event].phase == 'i') ? "\"s\":\"t\"," : "",
+           entry[6] | (entry[7] << 8));
+  }
+} /*** end of writeDump ***/
+
+
+/************************************************************************************//**
+** \brief     Decodes dumps to Chrome trace event JSON.
+** \return    Program exit code.
+**
+****************************************************************************************/
+int main(int argc, char *argv[])
+{
+  static uint8_t entries[MAX_ENTRIES * TRACE_ENTRY_SIZE];
+  uint8_t header[TRACE_HEADER_SIZE];
+  int first = 1;
+  int pid = 0;
+  FILE *f = stdin;
+
+  if((argc > 1) && ((f = fopen(argv[1], "rb")) == NULL))
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  printf("{\"traceEvents\":[");
+  while(readDump(f, header, entries) == 0)
+  {
+    writeDump(header, entries, ++pid, &first);
+  }
+  printf("\n]}\n");
+  if(!pid)
+  {
+    fprintf(stderr, "no trace dump found\n");
+  }
+  if(f != stdin)
+  {
+    fclose(f);
+  }
+  return pid ? 0 : 1;
+} /*** end of main ***/
+
+
+/******************************** end of trace_decode.c ********************************/
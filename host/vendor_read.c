@@ -0,0 +1,208 @@
+/************************************************************************************//**
+* \file     vendor_read.c
+* \brief    Reference host reader of the vendor bulk streaming interface of the DAQ.
+*
+*           Build: cc -std=c99 -O2 -o vendor_read vendor_read.c -lusb-1.0
+*           Usage: vendor_read [bytes]
+*           Binary data is read from bulk IN endpoint of interface 4 and written to
+*           standard output until the given number of bytes is read or the reader is
+*           interrupted. Commands are still sent to the first CDC port. Several
+*           transfers are kept queued, so the endpoint is never idle while data is
+*           written out. On Windows WinUSB or libusb driver must be bound to interface
+*           4 (MI_04).
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>                   /* Standard I/O functions.                        */
+#include <stdint.h>                  /* Standard integer types                         */
+#include <stdlib.h>                  /* Standard library                               */
+#include <signal.h>                  /* Signal handling                                */
+#include <libusb-1.0/libusb.h>       /* USB library                                    */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Vendor ID of the DAQ */
+#define DAQ_VID             0x03EB
+/** \brief Product ID of the DAQ, same as in conf_usb.h */
+#define DAQ_PID             0x2423
+/** \brief Vendor bulk interface, same as in vendor.h */
+#define DAQ_IFACE           4
+/** \brief Bulk IN endpoint of the interface */
+#define DAQ_EP_IN           0x87
+/** \brief Number of queued transfers */
+#define TRANSFERS           8
+/** \brief Size of one transfer, multiple of both packet sizes */
+#define TRANSFER_SIZE       16384
+/** \brief Transfer timeout in ms, 0 waits forever */
+#define TRANSFER_TIMEOUT    0
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+static void LIBUSB_CALL transferDone(struct libusb_transfer *transfer);
+static void stop(int sig);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Number of bytes still wanted, 0 reads forever */
+static uint64_t remaining = 0;
+/** \brief Number of transfers still queued */
+static int pending = 0;
+/** \brief Set when reading should stop */
+static volatile sig_atomic_t done = 0;
+
+
+/****************************************************************************************
+*                           H E L P E R   F U N C T I O N S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Writes received data to standard output and queues the transfer again.
+** \param     transfer Completed transfer.
+**
+****************************************************************************************/
+static void LIBUSB_CALL transferDone(struct libusb_transfer *transfer)
+{
+  uint64_t len = (uint64_t)transfer->actual_length;
+
+  pending--;
+  if(transfer->status != LIBUSB_TRANSFER_COMPLETED)
+  {
+    if(transfer->status != LIBUSB_TRANSFER_CANCELLED)
+    {
+      fprintf(stderr, "transfer failed: %d\n", transfer->status);
+    }
+    done = 1;
+    return;
+  }
+  if(remaining)
+  {
+    if(len >= remaining)
+    {
+      len = remaining;
+      done = 1;
+    }
+    remaining -= len;
+  }
+  if(fwrite(transfer->buffer, 1, (size_t)len, stdout) != len)
+  {
+    done = 1;
+  }
+  if(!done && (libusb_submit_transfer(transfer) == 0))
+  {
+    pending++;
+  }
+} /*** end of transferDone ***/
+
+/************************************************************************************//**
+** \brief     Signal handler, reading stops after queued transfers are cancelled.
+** \param     sig Signal number.
+**
+****************************************************************************************/
+static void stop(int sig)
+{
+  (void)sig;
+  done = 1;
+} /*** end of stop ***/
+
+
+/************************************************************************************//**
+** \brief     This is main program entry point
+** \return    0 if successful, 1 otherwise.
+**
+****************************************************************************************/
+int main(int argc, char *argv[])
+{
+  static uint8_t buf[TRANSFERS][TRANSFER_SIZE];
+  struct libusb_transfer *transfers[TRANSFERS] = {NULL};
+  libusb_device_handle *dev;
+  int result = 1;
+
+  if(argc > 1)
+  {
+    remaining = strtoull(argv[1], NULL, 0);
+  }
+  if(libusb_init(NULL) != 0)
+  {
+    fprintf(stderr, "libusb init failed\n");
+    return 1;
+  }
+  dev = libusb_open_device_with_vid_pid(NULL, DAQ_VID, DAQ_PID);
+  if(dev == NULL)
+  {
+    fprintf(stderr, "DAQ not found\n");
+    libusb_exit(NULL);
+    return 1;
+  }
+  if(libusb_claim_interface(dev, DAQ_IFACE) != 0)
+  {
+    fprintf(stderr, "unable to claim interface %d\n", DAQ_IFACE);
+    libusb_close(dev);
+    libusb_exit(NULL);
+    return 1;
+  }
+  signal(SIGINT, stop);
+
+  for(int i = 0; i < TRANSFERS; i++)
+  {
+    transfers[i] = libusb_alloc_transfer(0);
+    if(transfers[i] == NULL)
+    {
+      done = 1;
+      break;
+    }
+    libusb_fill_bulk_transfer(transfers[i], dev, DAQ_EP_IN, buf[i], TRANSFER_SIZE,
+                              transferDone, NULL, TRANSFER_TIMEOUT);
+    if(libusb_submit_transfer(transfers[i]) != 0)
+    {
+      done = 1;
+      break;
+    }
+    pending++;
+  }
+  if(!done)
+  {
+    result = 0;
+  }
+
+  while(!done)
+  {
+    if(libusb_handle_events(NULL) != 0)
+    {
+      done = 1;
+    }
+  }
+  /* Wait until every queued transfer returns before buffers are freed. */
+  for(int i = 0; i < TRANSFERS; i++)
+  {
+    if(transfers[i] != NULL)
+    {
+      libusb_cancel_transfer(transfers[i]);
+    }
+  }
+  while(pending > 0)
+  {
+    if(libusb_handle_events(NULL) != 0)
+    {
+      break;
+    }
+  }
+  fflush(stdout);
+  for(int i = 0; i < TRANSFERS; i++)
+  {
+    libusb_free_transfer(transfers[i]);
+  }
+  libusb_release_interface(dev, DAQ_IFACE);
+  libusb_close(dev);
+  libusb_exit(NULL);
+  return result;
+} /*** end of main ***/
+
+
+/********************************* end of vendor_read.c ********************************/
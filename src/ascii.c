@@ -0,0 +1,174 @@
+/************************************************************************************//**
+* \file     ascii.c
+* \brief    This module implements text output of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "ascii.h"                   /* Text output                                    */
+#include "profile.h"                 /* Cycle counter profiling                        */
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief ADC channel of every DAQ channel. */
+static const uint8_t asciiAdcCh[4] = {DAQ_CH_1_ADC_CH, DAQ_CH_2_ADC_CH,
+                                      DAQ_CH_3_ADC_CH, DAQ_CH_4_ADC_CH};
+
+
+/****************************************************************************************
+*                             A S C I I   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Formats completed block to text, one line per sample of all enabled
+**            channels. With averaging, consecutive samples of a channel are averaged to
+**            one value. Values are in fixed width and integer arithmetic only.
+** \param     block Pointer to completed ADC block.
+** \param     size Number of samples, block size or less for part of a block.
+** \param     settings Pointer to DAQ settings.
+** \param     out Text buffer, CORE_WORKSPACE_SIZE bytes.
+** \return    Length of text.
+**
+****************************************************************************************/
+uint16_t asciiFormatBlock(uint16_t *block, uint32_t size, daq_settings_t *settings,
+                          uint8_t *out)
+{
+  uint8_t chCount = coreGetChannelCount();
+  uint32_t rows;
+  uint16_t avg = settings->averaging ? settings->averaging : 1;
+  /* 10-bit codes are converted as 12-bit codes. */
+  uint8_t shift = settings->ADClowRes ? 2 : 0;
+  uint8_t width = settings->asciiUnit ? ASCII_WIDTH_UV : ASCII_WIDTH_MV;
+  uint8_t sep = (settings->asciiSeparator == ASCII_SEPARATOR_COMMA) ? ',' : ' ';
+  /* Gain of every ADC channel, samples are tagged with it. */
+  uint8_t gain[8];
+  uint16_t len = 0;
+  uint16_t *sample;
+  uint32_t sum, code;
+  int32_t val;
+
+  if(!chCount)
+  {
+    return 0;
+  }
+  rows = size / chCount;
+  /* Part of a block can be shorter than one row. */
+  if(!rows)
+  {
+    return 0;
+  }
+  PROFILE_START();
+  if(avg > rows)
+  {
+    avg = rows;
+  }
+  asciiGetGains(settings, gain);
+
+  for(uint32_t row = 0; row + avg <= rows; row += avg)
+  {
+    for(uint8_t ch = 0; ch < chCount; ch++)
+    {
+      sample = &block[row*chCount + ch];
+      sum = 0;
+      for(uint16_t i = 0; i < avg; i++)
+      {
+        sum += sample[i*chCount] & 0x0FFF;
+      }
+      /* Average in 12-bit code with 6 fractional bits. */
+      code = ((sum << (shift + 6)) + avg / 2) / avg;
+      val = asciiCodeToValue(code, gain[(*sample >> 12) & 0x07], settings->asciiUnit);
+      len += asciiFormatValue(val, width, &out[len]);
+      if(ch < chCount - 1)
+      {
+        out[len++] = sep;
+      }
+    }
+    out[len++] = '\n';
+    out[len++] = '\r';
+  }
+  PROFILE_STOP(PROFILE_FORMAT);
+  return len;
+} /*** end of asciiFormatBlock ***/
+
+/************************************************************************************//**
+** \brief     Obtains gain of every ADC channel, so gain of a sample is found by its tag.
+** \param     settings Pointer to DAQ settings.
+** \param     gain Gain of 8 ADC channels, channels not in use have gain 1.
+**
+****************************************************************************************/
+void asciiGetGains(daq_settings_t *settings, uint8_t *gain)
+{
+  for(uint8_t ch = 0; ch < 8; ch++)
+  {
+    gain[ch] = ADC_GAIN_1;
+  }
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    gain[asciiAdcCh[ch]] = settings->ADCgain[ch];
+  }
+} /*** end of asciiGetGains ***/
+
+/************************************************************************************//**
+** \brief     Converts 12-bit code to input voltage.
+** \param     code 12-bit code with 6 fractional bits.
+** \param     gain ADC gain of the channel.
+** \param     unit ASCII_UNIT_MV or ASCII_UNIT_UV.
+** \return    Input voltage in unit, rounded.
+**
+****************************************************************************************/
+int32_t asciiCodeToValue(uint32_t code, uint8_t gain, uint8_t unit)
+{
+  int32_t val;
+
+  val = (int32_t)(((uint64_t)code * (uint64_t)ASCII_UV_PER_CODE) >> 22) -
+        ASCII_FULL_SCALE_UV;
+  switch(gain)
+  {
+    case ADC_GAIN_0_5: val *= 2; break;
+    case ADC_GAIN_2:   val /= 2; break;
+  }
+  if(unit != ASCII_UNIT_UV)
+  {
+    val = (val + ((val < 0) ? -500 : 500)) / 1000;
+  }
+  return val;
+} /*** end of asciiCodeToValue ***/
+
+/************************************************************************************//**
+** \brief     Formats signed integer with sign, right aligned to width.
+** \param     val Value.
+** \param     width Number of characters, used if value is shorter. 0 = no padding.
+** \param     out Text buffer.
+** \return    Number of written characters.
+**
+****************************************************************************************/
+uint8_t asciiFormatValue(int32_t val, uint8_t width, uint8_t *out)
+{
+  uint8_t digits[10];
+  uint8_t count = 0;
+  uint8_t len = 0;
+  uint32_t mag = (val < 0) ? (uint32_t)(-val) : (uint32_t)val;
+
+  do
+  {
+    digits[count++] = '0' + (mag % 10);
+    mag /= 10;
+  } while(mag);
+
+  while(len + count + 1 < width)
+  {
+    out[len++] = ' ';
+  }
+  out[len++] = (val < 0) ? '-' : '+';
+  while(count)
+  {
+    out[len++] = digits[--count];
+  }
+  return len;
+} /*** end of asciiFormatValue ***/
+
+
+/************************************ end of ascii.c ***********************************/
@@ -0,0 +1,52 @@
+/************************************************************************************//**
+* \file     ascii.h
+* \brief    This module implements text output of the DAQ.
+****************************************************************************************/
+#ifndef ASCII_H_
+#define ASCII_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Units of text values */
+/** \brief Values are in millivolts */
+#define ASCII_UNIT_MV           0
+/** \brief Values are in microvolts */
+#define ASCII_UNIT_UV           1
+
+/* Separators of text values */
+/** \brief Values are separated by space */
+#define ASCII_SEPARATOR_SPACE   0
+/** \brief Values are separated by comma */
+#define ASCII_SEPARATOR_COMMA   1
+
+/** \brief Width of value in millivolts, sign and 5 digits */
+#define ASCII_WIDTH_MV          6
+/** \brief Width of value in microvolts, sign and 8 digits */
+#define ASCII_WIDTH_UV          9
+/** \brief Half of input range at gain 1 in microvolts */
+#define ASCII_FULL_SCALE_UV     10000000
+/** \brief Microvolts per 12-bit code at gain 1, 16 fractional bits (20 V / 4095) */
+#define ASCII_UV_PER_CODE       320078144
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint16_t asciiFormatBlock(uint16_t *block, uint32_t size, daq_settings_t *settings,
+                          uint8_t *out);
+void asciiGetGains(daq_settings_t *settings, uint8_t *gain);
+int32_t asciiCodeToValue(uint32_t code, uint8_t gain, uint8_t unit);
+uint8_t asciiFormatValue(int32_t val, uint8_t width, uint8_t *out);
+
+
+#endif /* ASCII_H_ */
+/************************************ end of ascii.h ***********************************/
@@ -0,0 +1,278 @@
+/************************************************************************************//**
+* \file     calibration.c
+* \brief    This module implements DAC to ADC loopback calibration of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "calibration.h"             /* Loopback calibration                           */
+#include "profile.h"                 /* Cycle counter profiling                        */
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void calMeasure(uint16_t dacCode, uint32_t chMask, uint32_t *sum);
+bool calFit(float *measured, float *ideal, int32_t *k, int32_t *c);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief ADC channel of every DAQ channel. */
+static const uint8_t calAdcCh[4] = {DAQ_CH_1_ADC_CH, DAQ_CH_2_ADC_CH,
+                                    DAQ_CH_3_ADC_CH, DAQ_CH_4_ADC_CH};
+/** \brief Nominal gain of every ADC gain setting. */
+static const float calNominal[CAL_GAINS] = {0.5f, 1.0f, 2.0f};
+/** \brief Correction gain of every gain setting and DAQ channel. */
+static int32_t calK[CAL_GAINS][4];
+/** \brief Correction offset of every gain setting and DAQ channel. */
+static int32_t calC[CAL_GAINS][4];
+/** \brief Indicates correction of gain setting and DAQ channel was measured. */
+static bool calValid[CAL_GAINS][4];
+
+
+/****************************************************************************************
+*                        C A L I B R A T I O N   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Measures loopback from DAC to every enabled channel at every ADC gain and
+**            fits correction which maps measured code to the code of an ideal channel.
+**            DAC output must be connected to enabled channels. Acquisition and DAC are
+**            stopped, settings of both are restored afterwards and the timers which
+**            were running are started again.
+** \param     settings Pointer to DAQ settings.
+** \return    Number of calibrated channel gains.
+**
+****************************************************************************************/
+uint8_t calRun(daq_settings_t *settings)
+{
+  Pdc *adcPdc = adc_get_pdc_base(ADC);
+  Pdc *dacPdc = dacc_get_pdc_base(DACC);
+  uint32_t adcMr = ADC->ADC_MR;
+  uint32_t adcCgr = ADC->ADC_CGR;
+  uint8_t transferMode = getDacTransferMode();
+  /* No TC interrupts are used, reading status clears nothing needed elsewhere. */
+  bool adcRunning = (tc_get_status(TC0, 0) & TC_SR_CLKSTA) != 0;
+  bool dacRunning = (tc_get_status(TC0, 1) & TC_SR_CLKSTA) != 0;
+  float measured[4][CAL_POINTS];
+  float ideal[CAL_POINTS];
+  uint32_t sum[4];
+  uint32_t chMask = 0;
+  uint32_t cgr;
+  uint16_t dacCode;
+  bool used[4] = {false, false, false, false};
+  uint8_t done = 0;
+
+  /* DAQ channels in sequence are calibrated. */
+  for(uint8_t idx = 0; ((idx < 4) && settings->sequence[idx]); idx++)
+  {
+    used[settings->sequence[idx] - 1] = true;
+    chMask |= 1 << calAdcCh[settings->sequence[idx] - 1];
+  }
+
+  /* Stop acquisition and DAC, both are driven by software during calibration. */
+  timerStop();
+  dacTimerStop();
+  adcHandler(false);
+  dacHandler(false);
+  pdc_disable_transfer(adcPdc, PERIPH_PTCR_RXTDIS);
+  pdc_disable_transfer(dacPdc, PERIPH_PTCR_TXTDIS);
+  adc_configure_trigger(ADC, ADC_TRIG_SW, 0);
+  ADC->ADC_MR &= ~ADC_MR_LOWRES;
+  dacc_disable_trigger(DACC);
+  setDacTransferMode(0);
+
+  for(uint8_t g = 0; g < CAL_GAINS; g++)
+  {
+    /* Same gain for all channels. */
+    cgr = 0;
+    for(uint8_t ch = 0; ch < 8; ch++)
+    {
+      cgr |= (uint32_t)g << (2 * ch);
+    }
+    ADC->ADC_CGR = cgr;
+
+    for(uint8_t p = 0; p < CAL_POINTS; p++)
+    {
+      dacCode = CAL_DAC_LOW + p * CAL_DAC_STEP;
+      ideal[p] = 2048.0f + ((float)dacCode - 2048.0f) * calNominal[g];
+      calMeasure(dacCode, chMask, sum);
+      for(uint8_t ch = 0; ch < 4; ch++)
+      {
+        measured[ch][p] = (float)sum[ch] / CAL_SAMPLES;
+      }
+    }
+
+    for(uint8_t ch = 0; ch < 4; ch++)
+    {
+      if(used[ch])
+      {
+        calValid[g][ch] = calFit(measured[ch], ideal, &calK[g][ch], &calC[g][ch]);
+        if(calValid[g][ch]) done++;
+      }
+    }
+  }
+
+  /* Restore ADC and DAC. */
+  ADC->ADC_CGR = adcCgr;
+  ADC->ADC_MR = adcMr;
+  dacc_set_trigger(DACC, 2);
+  setDacTransferMode(transferMode);
+  dacRestartPdc();
+  pdc_enable_transfer(dacPdc, PERIPH_PTCR_TXTEN);
+  adcRestartPdc();
+  adcHandler(true);
+  /* Acquisition and DAC continue as they were before calibration. */
+  if(dacRunning)
+  {
+    dacTimerStart();
+  }
+  if(adcRunning)
+  {
+    timerStart();
+  }
+
+  return done;
+} /*** end of calRun ***/
+
+/************************************************************************************//**
+** \brief     Outputs code on both DAC channels and sums ADC samples of channels.
+** \param     dacCode DAC code.
+** \param     chMask Mask of ADC channels to convert.
+** \param     sum Sum of CAL_SAMPLES samples of every DAQ channel.
+**
+****************************************************************************************/
+void calMeasure(uint16_t dacCode, uint32_t chMask, uint32_t *sum)
+{
+  uint32_t val;
+
+  /* DAC is free running, every write is converted. 12th bit selects channel 2. */
+  for(uint8_t ch = 0; ch < 2; ch++)
+  {
+    while(!(dacc_get_interrupt_status(DACC) & DACC_ISR_TXRDY));
+    dacc_write_conversion_data(DACC, dacCode | (ch << 12));
+  }
+
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    sum[ch] = 0;
+  }
+  /* First samples are dropped while DAC output settles. */
+  for(uint16_t i = 0; i < CAL_SETTLE_SAMPLES + CAL_SAMPLES; i++)
+  {
+    adc_start(ADC);
+    while((adc_get_status(ADC) & chMask) != chMask);
+    for(uint8_t ch = 0; ch < 4; ch++)
+    {
+      if(chMask & (1 << calAdcCh[ch]))
+      {
+        val = adc_get_channel_value(ADC, (enum adc_channel_num_t)calAdcCh[ch]);
+        if(i >= CAL_SETTLE_SAMPLES)
+        {
+          sum[ch] += val & 0x0FFF;
+        }
+      }
+    }
+  }
+} /*** end of calMeasure ***/
+
+/************************************************************************************//**
+** \brief     Least squares fit of line mapping measured codes to ideal codes.
+** \param     measured Averaged measured codes.
+** \param     ideal Ideal codes.
+** \param     k Correction gain, CAL_SHIFT fractional bits.
+** \param     c Correction offset, CAL_SHIFT fractional bits.
+** \return    True if successful, false if channel is saturated or not connected.
+**
+****************************************************************************************/
+bool calFit(float *measured, float *ideal, int32_t *k, int32_t *c)
+{
+  float mx = 0.0f, my = 0.0f, sxx = 0.0f, sxy = 0.0f;
+  float a, b;
+
+  for(uint8_t p = 0; p < CAL_POINTS; p++)
+  {
+    /* Saturated point does not lie on the line. */
+    if((measured[p] < CAL_CODE_MARGIN) || (measured[p] > 4095 - CAL_CODE_MARGIN))
+    {
+      return false;
+    }
+    mx += measured[p];
+    my += ideal[p];
+  }
+  mx /= CAL_POINTS;
+  my /= CAL_POINTS;
+  for(uint8_t p = 0; p < CAL_POINTS; p++)
+  {
+    sxx += (measured[p] - mx) * (measured[p] - mx);
+    sxy += (measured[p] - mx) * (ideal[p] - my);
+  }
+  if(sxx <= 0.0f)
+  {
+    return false;
+  }
+  a = sxy / sxx;
+  b = my - a * mx;
+  if((a < CAL_MIN_GAIN) || (a > CAL_MAX_GAIN))
+  {
+    return false;
+  }
+
+  /* Round to nearest. */
+  *k = (int32_t)(a * (1 << CAL_SHIFT) + 0.5f);
+  *c = (int32_t)(b * (1 << CAL_SHIFT) + ((b < 0.0f) ? -0.5f : 0.5f));
+  return true;
+} /*** end of calFit ***/
+
+/************************************************************************************//**
+** \brief     Corrects every sample with correction of its channel and current gain.
+**            Channels without correction are left as they are.
+** \param     block Pointer to completed ADC block or its part.
+** \param     size Number of samples.
+** \param     settings Pointer to DAQ settings.
+**
+****************************************************************************************/
+void calApply(uint16_t *block, uint32_t size, daq_settings_t *settings)
+{
+  /* 10-bit codes are corrected as 12-bit codes. */
+  uint8_t shift = settings->ADClowRes ? 2 : 0;
+  int32_t max = settings->ADClowRes ? 1023 : 4095;
+  int32_t round = 1 << (CAL_SHIFT + shift - 1);
+  /* Correction of every ADC channel, samples are tagged with it. */
+  int32_t k[8], c[8];
+  uint8_t tag, g;
+  int32_t val;
+  PROFILE_START();
+
+  for(uint8_t ch = 0; ch < 8; ch++)
+  {
+    k[ch] = 1 << CAL_SHIFT;
+    c[ch] = 0;
+  }
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    g = settings->ADCgain[ch];
+    if((g < CAL_GAINS) && calValid[g][ch])
+    {
+      k[calAdcCh[ch]] = calK[g][ch];
+      c[calAdcCh[ch]] = calC[g][ch];
+    }
+  }
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    tag = (block[i] >> 12) & 0x07;
+    val = ((int32_t)(block[i] & 0x0FFF) << shift) * k[tag] + c[tag] + round;
+    val >>= CAL_SHIFT + shift;
+    if(val < 0)   val = 0;
+    if(val > max) val = max;
+    block[i] = (uint16_t)val | (block[i] & 0xF000);
+  }
+  PROFILE_STOP(PROFILE_CALIBRATION);
+} /*** end of calApply ***/
+
+
+/********************************* end of calibration.c ********************************/
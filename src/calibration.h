@@ -0,0 +1,57 @@
+/************************************************************************************//**
+* \file     calibration.h
+* \brief    This module implements DAC to ADC loopback calibration of the DAQ.
+****************************************************************************************/
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Calibration command values */
+/** \brief Samples are sent as measured */
+#define CAL_OFF             0
+/** \brief Samples are corrected before they are sent */
+#define CAL_ON              1
+/** \brief Calibration is measured, then samples are corrected */
+#define CAL_RUN             2
+
+/** \brief Number of ADC gain settings */
+#define CAL_GAINS           3
+/** \brief Number of DAC codes measured for every gain */
+#define CAL_POINTS          8
+/** \brief Lowest DAC code, codes are centered so they fit ADC range with gain 2 */
+#define CAL_DAC_LOW         (2048 - 896)
+/** \brief Step between two DAC codes */
+#define CAL_DAC_STEP        256
+/** \brief Number of averaged ADC samples for every DAC code */
+#define CAL_SAMPLES         64
+/** \brief Number of ADC samples dropped after DAC code changes */
+#define CAL_SETTLE_SAMPLES  16
+/** \brief Averaged codes closer than this to the end of range are saturated */
+#define CAL_CODE_MARGIN     16
+/** \brief Fixed point of correction gain and offset */
+#define CAL_SHIFT           14
+/** \brief Lowest accepted correction gain */
+#define CAL_MIN_GAIN        0.5f
+/** \brief Highest accepted correction gain */
+#define CAL_MAX_GAIN        2.0f
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint8_t calRun(daq_settings_t *settings);
+void calApply(uint16_t *block, uint32_t size, daq_settings_t *settings);
+
+
+#endif /* CALIBRATION_H_ */
+/********************************* end of calibration.h ********************************/
@@ -0,0 +1,56 @@
+/************************************************************************************//**
+* \file     capability.c
+* \brief    This module implements capability descriptor of the DAQ. Host reads limits
+*           of this build and measured throughput instead of hard-coding them, so it
+*           can choose the fastest configuration every unit supports.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "capability.h"              /* Capability descriptor                          */
+#include "parser.h"                  /* Command parser and parameter ranges            */
+
+
+/****************************************************************************************
+*                                  C A P A B I L I T Y
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Fills capability descriptor.
+** \param     descriptor Descriptor to fill.
+**
+****************************************************************************************/
+void capabilityGet(capability_t *descriptor)
+{
+  uint32_t cpuHz = sysclk_get_cpu_hz();
+
+  descriptor->id[0] = 'C';
+  descriptor->id[1] = 'A';
+  descriptor->version = CAPABILITY_VERSION;
+  descriptor->size = sizeof(capability_t);
+  descriptor->firmware[0] = USB_DEVICE_MAJOR_VERSION;
+  descriptor->firmware[1] = USB_DEVICE_MINOR_VERSION;
+  descriptor->protocol = CAPABILITY_PROTOCOL;
+  descriptor->modes = (1ul << (MODE_HIGHRANGE + 1)) - 1;
+  descriptor->encodings = (1 << PACK_OFF) | (1 << PACK_ON) | (1 << PACK_RICE);
+  descriptor->resolutions = (1 << ADC_RES_12_BITS) | (1 << ADC_RES_10_BITS);
+  descriptor->channels = SEQUENCER_HIGHRANGE;
+  descriptor->adcBlocks = ADC_BLOCKS;
+  descriptor->adcBufferSize = ADC_BUFFER_SIZE;
+  descriptor->daccBufferSize = DACC_BUFFER_SIZE;
+  descriptor->blockSizeMin = BLOCK_SIZE_MIN;
+  descriptor->blockSizeMax = BLOCK_SIZE_MAX;
+  descriptor->replySize = TX_CONTROL_SIZE;
+  descriptor->vendorSize = VENDOR_BUFFER_SIZE;
+  descriptor->periodMin = SAMPLE_PERIOD_LOWRANGE;
+  descriptor->periodMax = SAMPLE_PERIOD_HIGHRANGE;
+  descriptor->cpuHz = cpuHz;
+  /* Sample timer uses MCK/2 at most, DAC timer runs from MCK/32. */
+  descriptor->adcTimerHz = cpuHz / 2;
+  descriptor->dacTimerHz = cpuHz / 32;
+  statusGetRate(&descriptor->txRate, &descriptor->txRatePeak);
+} /*** end of capabilityGet ***/
+
+
+/********************************* end of capability.c *********************************/
@@ -0,0 +1,65 @@
+/************************************************************************************//**
+* \file     capability.h
+* \brief    This module implements capability descriptor of the DAQ.
+****************************************************************************************/
+#ifndef CAPABILITY_H_
+#define CAPABILITY_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Version of descriptor, changes when its layout changes */
+#define CAPABILITY_VERSION  1
+/** \brief Version of command protocol, changes when commands or their replies change */
+#define CAPABILITY_PROTOCOL 1
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Capability descriptor sent by capability command, little endian */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  uint8_t id[2];                     /* 'C', 'A'                                       */
+  uint8_t version;                   /* CAPABILITY_VERSION                             */
+  uint8_t size;                      /* Bytes of whole descriptor                      */
+  uint8_t firmware[2];               /* Major and minor version of USB device release  */
+  uint16_t protocol;                 /* CAPABILITY_PROTOCOL                            */
+  uint32_t modes;                    /* Bit of every supported mode of M command       */
+  uint8_t encodings;                 /* Bit of every supported encoding of Q command   */
+  uint8_t resolutions;               /* Bit of every supported resolution parameter    */
+  uint8_t channels;                  /* Most channels in sequence                      */
+  uint8_t adcBlocks;                 /* Blocks PDC fills in turns                      */
+  uint16_t adcBufferSize;            /* ADC_BUFFER_SIZE                                */
+  uint16_t daccBufferSize;           /* DACC_BUFFER_SIZE                               */
+  uint16_t blockSizeMin;             /* Least samples in block                         */
+  uint16_t blockSizeMax;             /* Most samples in block                          */
+  uint16_t replySize;                /* Bytes of command reply buffer                  */
+  uint16_t vendorSize;               /* Bytes of one vendor interface transfer         */
+  uint32_t periodMin;                /* Shortest sample period in us                   */
+  uint32_t periodMax;                /* Longest sample period in us                    */
+  uint32_t cpuHz;                    /* CPU and master clock                           */
+  uint32_t adcTimerHz;               /* Fastest clock of sample timer                  */
+  uint32_t dacTimerHz;               /* Clock of DAC timer, unit of DAC period         */
+  uint32_t txRate;                   /* Bytes per second sent in the last second       */
+  uint32_t txRatePeak;               /* Most bytes per second sent since boot          */
+}capability_t;
+COMPILER_PACK_RESET()
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void capabilityGet(capability_t *descriptor);
+
+
+#endif /* CAPABILITY_H_ */
+/********************************* end of capability.h *********************************/
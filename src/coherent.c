@@ -0,0 +1,245 @@
+/************************************************************************************//**
+* \file     coherent.c
+* \brief    This module implements coherent averaging mode of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "coherent.h"                /* Coherent averaging mode                        */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Sums of every sample in period in workspace, averaged period when ready. */
+#define COHERENT_ACC        ((uint32_t *)coreGetWorkspace())
+
+#if (COHERENT_MAX_SAMPLES * 4) > CORE_WORKSPACE_SIZE
+#error "Coherent averaging buffer does not fit to core workspace"
+#endif
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void coherentArm(void);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Structure with all the settings. */
+static daq_settings_t * coherentSettings;
+/** \brief Number of periods accumulated so far. */
+static uint16_t coherentCount = 0;
+/** \brief Indicates averaging is running. */
+static volatile bool coherentActive = false;
+/** \brief Indicates averaged period is waiting to be sent. */
+static volatile bool coherentReady = false;
+/** \brief Number of samples of one period. */
+static uint32_t coherentSamples;
+/** \brief Sync bytes marking start of averaged period. */
+static uint8_t coherentSync[2];
+/** \brief Block size of user, restored when averaging stops. */
+static uint32_t coherentSavedBlockSize;
+/** \brief Sync bytes of user, restored when averaging stops. */
+static uint8_t coherentSavedSync[2];
+
+
+/****************************************************************************************
+*                          A V E R A G I N G   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Starts DAC together with ADC. ADC is triggered by DAC timer and block size
+**            is set to one LUT period, so every block starts at LUT index 0 and holds
+**            the same part of the response. Blocks are summed sample by sample until
+**            NumOfRepeats periods are accumulated. If samples are lost, averaging
+**            starts again aligned. Block size is restored by coherentStop.
+** \param     settings Pointer to DAQ settings.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool coherentStart(daq_settings_t *settings)
+{
+  uint8_t chCount = coreGetChannelCount();
+  /* In word mode one LUT value holds both channels, DAC needs a trigger for each. */
+  uint32_t triggers = (uint32_t)settings->LutLength * (getDacTransferMode() ? 2 : 1);
+  uint32_t samples = triggers * chCount;
+
+  /* Check if one period fits to ADC buffer and the average is finite. */
+  if(!samples || (samples > COHERENT_MAX_SAMPLES) || !settings->NumOfRepeats ||
+     (settings->DacPeriod < COHERENT_MIN_PERIOD))
+  {
+    return false;
+  }
+
+  /* Stop anything that is running, previous averaging gives block size back first. */
+  coherentStop();
+  timerStop();
+  dacTimerStop();
+
+  coherentSettings = settings;
+  coherentSamples = samples;
+  coherentReady = false;
+
+  /* One block is one period. */
+  coherentSavedBlockSize = *settings->blockSize;
+  coherentSavedSync[0] = settings->syncBytes[0];
+  coherentSavedSync[1] = settings->syncBytes[1];
+  coherentSync[0] = ( (uint16_t)samples       & 0b1111111) | 0b10000000;
+  coherentSync[1] = (((uint16_t)samples >> 7) & 0b1111111) | 0b10000000;
+  *settings->blockSize = samples;
+  settings->syncBytes[0] = coherentSync[0];
+  settings->syncBytes[1] = coherentSync[1];
+
+  adcSetTrigger(true);
+  adcHandler(true);
+  coherentActive = true;
+  coherentArm();
+
+  return true;
+} /*** end of coherentStart ***/
+
+/************************************************************************************//**
+** \brief     Clears sums and starts DAC and ADC PDC again from the start of LUT and of
+**            block, so first ADC sample and first LUT value belong to the same trigger.
+**            DACC_Handler counts repeats from 0 again.
+**
+****************************************************************************************/
+void coherentArm(void)
+{
+  uint32_t *coherentAcc = COHERENT_ACC;
+
+  dacTimerStop();
+  for(uint32_t i = 0; i < coherentSamples; i++)
+  {
+    coherentAcc[i] = 0;
+  }
+  coherentCount = 0;
+  coherentSettings->CurrentRepeats = 0;
+  adcRestartPdc();
+  dacRestartPdc();
+  dacTimerStart();
+} /*** end of coherentArm ***/
+
+/************************************************************************************//**
+** \brief     Stops averaging and gives ADC trigger back to ADC timer. Block size and
+**            sync bytes of user are restored.
+**
+****************************************************************************************/
+void coherentStop(void)
+{
+  if(coherentActive)
+  {
+    coherentActive = false;
+    adcSetTrigger(false);
+    *coherentSettings->blockSize = coherentSavedBlockSize;
+    coherentSettings->syncBytes[0] = coherentSavedSync[0];
+    coherentSettings->syncBytes[1] = coherentSavedSync[1];
+    adcRestartPdc();
+  }
+} /*** end of coherentStop ***/
+
+/************************************************************************************//**
+** \brief     Stops averaging and drops averaged period which was not sent yet.
+**
+****************************************************************************************/
+void coherentReset(void)
+{
+  coherentStop();
+  coherentReady = false;
+} /*** end of coherentReset ***/
+
+/************************************************************************************//**
+** \brief     Checks if averaging is running.
+** \return    True if averaging is running, false otherwise.
+**
+****************************************************************************************/
+bool coherentIsActive(void)
+{
+  return coherentActive;
+} /*** end of coherentIsActive ***/
+
+/************************************************************************************//**
+** \brief     Adds completed period to the sums. After the last period the averaged
+**            period is prepared for sending and averaging is stopped. Block after lost
+**            samples is shifted against LUT period, like every block after it, so the
+**            sums are dropped and averaging starts again aligned.
+** \param     block Pointer to completed ADC block.
+** \param     gap True if samples were lost before or within the block.
+** \return    True if averaged period is ready, false otherwise.
+**
+****************************************************************************************/
+bool coherentProcess(uint16_t *block, bool gap)
+{
+  uint32_t *coherentAcc = COHERENT_ACC;
+  uint32_t size = coherentSamples;
+  uint32_t val;
+
+  if(gap)
+  {
+    coherentArm();
+    return false;
+  }
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    coherentAcc[i] += block[i] & 0x0FFF;
+  }
+
+  /* Not enough periods to average yet. */
+  if(++coherentCount < coherentSettings->NumOfRepeats)
+  {
+    return false;
+  }
+
+  /* Store rounded average over the sums, channel tag of every sample is kept. */
+  for(uint32_t i = 0; i < size; i++)
+  {
+    val = (coherentAcc[i] + coherentCount / 2) / coherentCount;
+    ((uint16_t *)coherentAcc)[i] = (uint16_t)val | (block[i] & 0xF000);
+  }
+  coherentStop();
+  coherentReady = true;
+
+  return true;
+} /*** end of coherentProcess ***/
+
+/************************************************************************************//**
+** \brief     Checks if averaged period is waiting to be sent.
+** \return    True if averaged period is ready, false otherwise.
+**
+****************************************************************************************/
+bool coherentIsReady(void)
+{
+  return coherentReady;
+} /*** end of coherentIsReady ***/
+
+/************************************************************************************//**
+** \brief     Queues averaged period in the same format as a block in BIN mode.
+**
+****************************************************************************************/
+void coherentSend(void)
+{
+  if(!txFrame(coherentSync, 2, (uint8_t *)COHERENT_ACC, coherentSamples * 2,
+              coherentSent))
+  {
+    coherentReady = false;
+  }
+} /*** end of coherentSend ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when averaged period was sent.
+** \param     buf Start of the frame, sync bytes.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void coherentSent(uint8_t *buf, uint32_t len)
+{
+  coherentReady = false;
+} /*** end of coherentSent ***/
+
+
+/********************************** end of coherent.c **********************************/
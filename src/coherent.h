@@ -0,0 +1,40 @@
+/************************************************************************************//**
+* \file     coherent.h
+* \brief    This module implements coherent averaging mode of the DAQ.
+****************************************************************************************/
+#ifndef COHERENT_H_
+#define COHERENT_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "tx.h"                      /* Transmit arbiter                               */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Shortest DAC trigger period in us, ADC converts all channels on it */
+#define COHERENT_MIN_PERIOD   10
+/** \brief Maximum number of samples in one averaged period of all channels together */
+#define COHERENT_MAX_SAMPLES  (ADC_BUFFER_SIZE * 4)
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+bool coherentStart(daq_settings_t *settings);
+void coherentStop(void);
+void coherentReset(void);
+bool coherentIsActive(void);
+bool coherentProcess(uint16_t *block, bool gap);
+bool coherentIsReady(void);
+void coherentSend(void);
+void coherentSent(uint8_t *buf, uint32_t len);
+
+
+#endif /* COHERENT_H_ */
+/********************************** end of coherent.h **********************************/
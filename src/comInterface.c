@@ -9,29 +9,53 @@
 #include <asf.h>                     /* Atmel Software Framework include file          */
 #include <stdio.h>                   /* Standard I/O functions.                        */
 #include "comInterface.h"            /* USB interface driver                           */
+#include "vendor.h"                  /* Vendor bulk streaming interface                */
 
 
 /***************************************************************************************
 * Function prototypes
 ****************************************************************************************/
 uint8_t init(void *ptr);             /* Initialize comunication interface              */
-uint8_t available(void);             /* Returns number of bytes in receive buffer      */
-uint8_t read(void);                  /* Reads single byte from receive buffer          */
-uint8_t write(uint8_t *payload);     /* Writes single byte to the interface            */
-uint8_t printbuf(uint8_t *bufPtr, uint16_t len);  /* Writes buffer to the interface    */
+uint8_t available(uint8_t port);     /* Returns number of bytes in receive buffer      */
+uint8_t read(uint8_t port);          /* Reads single byte from receive buffer          */
+uint8_t write(uint8_t port, uint8_t *payload);  /* Writes single byte to the interface */
+uint8_t printbuf(uint8_t port, uint8_t *bufPtr, uint16_t len);  /* Writes buffer       */
+uint16_t txfree(uint8_t port);       /* Returns free space in transmit buffer          */
+/* Functions of every port, linked to its interface structure. */
+uint8_t available0(void);
+uint8_t read0(void);
+uint8_t write0(uint8_t *payload);
+uint8_t printbuf0(uint8_t *bufPtr, uint16_t len);
+uint16_t txfree0(void);
+uint8_t available1(void);
+uint8_t read1(void);
+uint8_t write1(uint8_t *payload);
+uint8_t printbuf1(uint8_t *bufPtr, uint16_t len);
+uint16_t txfree1(void);
 
 
 /****************************************************************************************
 * Local data declarations
 ****************************************************************************************/
-/** \brief Comunication interface structure */
-COM_t comInterface =
+/** \brief Comunication interface structure of every port */
+COM_t comInterface[UDI_CDC_PORT_NB] =
 {
-  init,
-  available,
-  read,
-  write,
-  printbuf,
+  {
+    init,
+    available0,
+    read0,
+    write0,
+    printbuf0,
+    txfree0,
+  },
+  {
+    init,
+    available1,
+    read1,
+    write1,
+    printbuf1,
+    txfree1,
+  },
 };
 
 
@@ -39,18 +63,24 @@ COM_t comInterface =
 *                    C O M U N I C A T I O N   U T I L I T I E S
 ****************************************************************************************/
 /************************************************************************************//**
-** \brief     Obtains a pointer to the USB interface structure.
+** \brief     Obtains a pointer to the USB interface structure of a port.
+** \param     port COM_PORT_CONTROL, COM_PORT_TEXT or COM_PORT_DATA.
 ** \return    Pointer to USB interface structure.
 **
 ****************************************************************************************/
-COM_t *getComInterface()
+COM_t *getComInterface(uint8_t port)
 {
-  return &comInterface;
+  /* Ports after CDC ports belong to vendor bulk interface. */
+  if(port >= UDI_CDC_PORT_NB)
+  {
+    return vendorGetComInterface();
+  }
+  return &comInterface[port];
 } /*** end of getComInterface ***/
 
 
 /************************************************************************************//**
-** \brief     Initializes the USB interface.
+** \brief     Initializes the USB interface, all ports together.
 ** \param     settings Pointer to the USB interface settings.
 **
 ****************************************************************************************/
@@ -58,6 +88,13 @@ uint8_t init(void *ptr) //initialize communication
 {
   /* Set result to false. */
   bool result = 0;
+  /* USB stack is started once for all ports. */
+  static bool started = false;
+  if(started)
+  {
+    return 1;
+  }
+  started = true;
   /* USB stack, ASF */
   udc_start();
   result = 1;
@@ -68,48 +105,128 @@ uint8_t init(void *ptr) //initialize communication
 
 /************************************************************************************//**
 ** \brief     Return length of data in receive buffer.
+** \param     port Port number.
 ** \return    Length of data in receive buffer.
 **
 ****************************************************************************************/
-uint8_t available()
+uint8_t available(uint8_t port)
 {
-  return udi_cdc_get_nb_received_data();
+  return udi_cdc_multi_get_nb_received_data(port);
 } /*** end of available ***/
 
 
 /************************************************************************************//**
 ** \brief     Return char from receive buffer.
+** \param     port Port number.
 ** \return    Return next uint8_t from buffer.
 **
 ****************************************************************************************/
-uint8_t read()
+uint8_t read(uint8_t port)
 {
-  return udi_cdc_getc();
+  return udi_cdc_multi_getc(port);
 } /*** end of read ***/
 
 
 /************************************************************************************//**
 ** \brief     Write single char to interface.
+** \param     port Port number.
 ** \return    Return result.
 **
 ****************************************************************************************/
-uint8_t write(uint8_t *payload)
+uint8_t write(uint8_t port, uint8_t *payload)
 {
-  return udi_cdc_write_buf(&payload, 1);
+  return udi_cdc_multi_write_buf(port, payload, 1);
 } /*** end of write ***/
 
 
 /************************************************************************************//**
 ** \brief     Print buffer to interface
+** \param     port Port number.
 ** \return    Return result.
 **
 ****************************************************************************************/
-uint8_t printbuf(uint8_t *bufPtr, uint16_t len)
+uint8_t printbuf(uint8_t port, uint8_t *bufPtr, uint16_t len)
 {
-  return udi_cdc_multi_write_buf(0, bufPtr, len);
+  return udi_cdc_multi_write_buf(port, bufPtr, len);
 } /*** end of printbuf ***/
 
 
+/************************************************************************************//**
+** \brief     Return free space in transmit buffer.
+** \param     port Port number.
+** \return    Number of bytes which can be written without waiting.
+**
+****************************************************************************************/
+uint16_t txfree(uint8_t port)
+{
+  return udi_cdc_multi_get_free_tx_buffer(port);
+} /*** end of txfree ***/
+
+
+/****************************************************************************************
+*                            P O R T   F U N C T I O N S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Functions of port 0. Interface structure has no port parameter, so every
+**            CDC port links its own functions.
+**
+****************************************************************************************/
+uint8_t available0(void)
+{
+  return available(0);
+}
+
+uint8_t read0(void)
+{
+  return read(0);
+}
+
+uint8_t write0(uint8_t *payload)
+{
+  return write(0, payload);
+}
+
+uint8_t printbuf0(uint8_t *bufPtr, uint16_t len)
+{
+  return printbuf(0, bufPtr, len);
+}
+
+uint16_t txfree0(void)
+{
+  return txfree(0);
+} /*** end of port 0 functions ***/
+
+/************************************************************************************//**
+** \brief     Functions of port 1, see functions of port 0.
+**
+****************************************************************************************/
+uint8_t available1(void)
+{
+  return available(1);
+}
+
+uint8_t read1(void)
+{
+  return read(1);
+}
+
+uint8_t write1(uint8_t *payload)
+{
+  return write(1, payload);
+}
+
+uint8_t printbuf1(uint8_t *bufPtr, uint16_t len)
+{
+  return printbuf(1, bufPtr, len);
+}
+
+uint16_t txfree1(void)
+{
+  return txfree(1);
+} /*** end of port 1 functions ***/
+
+
+
 /****************************************************************************************
 *                        C A L L B A C K   F U N C T I O N S
 ****************************************************************************************/
@@ -120,9 +237,9 @@ uint8_t printbuf(uint8_t *bufPtr, uint16_t len)
 void udi_cdc_callback_rx_notify(uint8_t port)
 {
   /* Only continue if callback function was linked. */
-  if(comInterface.rxCallback != NULL)
+  if(comInterface[port].rxCallback != NULL)
   {
-    comInterface.rxCallback();
+    comInterface[port].rxCallback();
   }
 } /*** end of udi_cdc_callback_rx_notify ***/
 
@@ -134,9 +251,9 @@ void udi_cdc_callback_rx_notify(uint8_t port)
 void udi_cdc_callback_tx_empty_notify(uint8_t port)
 {
   /* Only continue if callback function was linked. */
-  if(comInterface.txEmptyCallback != NULL)
+  if(comInterface[port].txEmptyCallback != NULL)
   {
-    comInterface.txEmptyCallback();
+    comInterface[port].txEmptyCallback();
   }
 } /*** end of udi_cdc_callback_tx_empty_notify ***/
 
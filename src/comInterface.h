@@ -19,10 +19,21 @@
   #define comBufLen 256
 #endif
 
+/* Ports of the interface, CDC ports first, see UDI_CDC_PORT_NB in conf_usb.h */
+/** \brief CDC port of commands and their replies */
+#define COM_PORT_CONTROL    0
+/** \brief CDC port of acquired data as text, read by terminal or saved to file */
+#define COM_PORT_TEXT       1
+/** \brief Vendor bulk interface of acquired binary data */
+#define COM_PORT_DATA       UDI_CDC_PORT_NB
+
 
 /****************************************************************************************
 * Type definitions
 ****************************************************************************************/
+/** \brief Called when buffer given to the interface by reference was sent or dropped */
+typedef void (*com_done_t)(uint8_t *buf, uint32_t len);
+
 /** \brief Comunication interface structure */
 typedef struct
 {
@@ -31,6 +42,8 @@ typedef struct
   uint8_t (* read) (void);                  /* Reads single byte from receive buffer   */
   uint8_t (* write) (uint8_t*);             /* Writes single byte to the interface     */
   uint8_t (* printBuf) (uint8_t*, uint16_t);/* Writes buffer to the interface          */
+  uint16_t (* txFree) (void);               /* Bytes writable without waiting          */
+  uint8_t (* submit) (uint8_t*, uint16_t, com_done_t);/* Sends buffer as is, or NULL   */
   void    (* rxCallback) (void);            /* Pointer to the callback funcion handler */
   void    (* txEmptyCallback) (void);       /* Pointer to the callback funcion handler */
   uint8_t buf[comBufLen];                   /* Communication transmit buffer           */
@@ -41,7 +54,7 @@ typedef struct
 /***************************************************************************************
 * Function prototypes
 ****************************************************************************************/
-COM_t *getComInterface(void);               /* Gets struct of communiaction interface  */
+COM_t *getComInterface(uint8_t port);       /* Gets struct of communiaction interface  */
 /* Callback functions. */
 void udi_cdc_callback_rx_notify(uint8_t port);       /* UDI specific callback function */
 void udi_cdc_callback_tx_empty_notify(uint8_t port); /* UDI specific callback function */
@@ -56,7 +56,7 @@
 
 //! Device definition (mandatory)
 #define  USB_DEVICE_VENDOR_ID             USB_VID_ATMEL
-#define  USB_DEVICE_PRODUCT_ID            USB_PID_ATMEL_ASF_CDC
+#define  USB_DEVICE_PRODUCT_ID            USB_PID_ATMEL_ASF_VENDOR_CLASS
 #define  USB_DEVICE_MAJOR_VERSION         1
 #define  USB_DEVICE_MINOR_VERSION         0
 #define  USB_DEVICE_POWER                 100 // Consumption on Vbus line (mA)
@@ -90,8 +90,7 @@
  */
 // #define  UDC_VBUS_EVENT(b_vbus_high)      user_callback_vbus_action(b_vbus_high)
 // extern void user_callback_vbus_action(bool b_vbus_high);
-// #define  UDC_SOF_EVENT()                  user_callback_sof_action()
-// extern void user_callback_sof_action(void);
+#define  UDC_SOF_EVENT()                  coreSofCallback()
 // #define  UDC_SUSPEND_EVENT()              user_callback_suspend_action()
 // extern void user_callback_suspend_action(void);
 // #define  UDC_RESUME_EVENT()               user_callback_resume_action()
@@ -119,7 +118,9 @@
  */
 
 //! Number of communication port used (1 to 3)
-#define  UDI_CDC_PORT_NB 1
+//! Port 0 carries commands and replies, port 1 text of ASCII, CSV and deadband modes.
+//! Binary data is sent on vendor interface.
+#define  UDI_CDC_PORT_NB 2
 
 //! Interface callback definition
 #define  UDI_CDC_ENABLE_EXT(port)          true
@@ -162,12 +163,24 @@
  * USB Device Driver Configuration
  * @{
  */
+//! Interrupt priority of UDP, see priority plan in core.h
+#define  UDD_USB_INT_LEVEL                USB_IRQ_PRIORITY
 //@}
 
 #define USB_DEVICE_EP_CTRL_SIZE 64
 
 //! The includes of classes and other headers must be done at the end of this file to avoid compile error
 #include "udi_cdc_conf.h"
+
+/**
+ * Composite device, CDC ports and vendor bulk interface (see usbDescriptors.c)
+ * @{
+ */
+#define  USB_DEVICE_NB_INTERFACE          5
+#undef   USB_DEVICE_MAX_EP
+#define  USB_DEVICE_MAX_EP                7
+//@}
+
 #include "comInterface.h"
 #include "core.h"
 
@@ -7,7 +7,41 @@
 * Include files
 ****************************************************************************************/
 #include <asf.h>                     /* Atmel Software Framework include file          */
+#include <string.h>                  /* Memory functions                               */
 #include "core.h"                    /* Core functionality for acquisition             */
+#include "spectrum.h"                /* Spectrum mode                                  */
+#include "fra.h"                     /* Frequency response analyser                    */
+#include "coherent.h"                /* Coherent averaging mode                        */
+#include "histogram.h"               /* Histogram mode                                 */
+#include "calibration.h"             /* Loopback calibration                           */
+#include "ascii.h"                   /* Text output                                    */
+#include "csv.h"                     /* CSV streaming mode                             */
+#include "pack.h"                    /* Packed sample encoding                         */
+#include "deadband.h"                /* Report by exception mode                       */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "event.h"                   /* Event queues                                   */
+#include "profile.h"                 /* Cycle counter profiling                        */
+#include "status.h"                  /* Health and throughput counters                 */
+#include "trace.h"                   /* Event trace                                    */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#if EVENT_QUEUE_SIZE <= ADC_BLOCKS
+#error "Every completed ADC block must fit to event queue"
+#endif
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief ADC block, frame header is written right before samples */
+typedef struct
+{
+  uint8_t header[ADC_HEADER_SLOT];   /* Room for frame header, ends at first sample    */
+  uint16_t samples[ADC_BUFFER_SIZE][4];/* Samples stored by PDC                        */
+}adc_block_t;
 
 
 /***************************************************************************************
@@ -18,6 +52,18 @@ bool dacInit(void);
 bool adcInit(void);
 bool pdcInit(void);
 void comTxEmptyCallback(void);
+void coreTxReady(uint32_t par);
+void coreProcessBlock(uint32_t idx);
+void coreFlushPart(uint32_t par);
+void coreSendBlock(uint8_t idx, uint32_t first);
+bool coreSendPart(uint16_t *samples, uint32_t count);
+uint32_t coreGetRowSize(void);
+uint32_t coreAverageBlock(uint16_t *block, uint32_t size, uint16_t *out);
+void coreBlockSent(uint8_t *buf, uint32_t len);
+void coreWorkspaceSent(uint8_t *buf, uint32_t len);
+void adcStartBlock(void);
+void adcQueueNext(void);
+void adcOverrun(void);
 
 
 /****************************************************************************************
@@ -29,14 +75,49 @@ static daq_settings_t * settings;
 Pdc * adcPdc;
 /** \brief ADC PDC packet. */
 pdc_packet_t adcPdcPacket;
-/** \brief ADC PDC buffer. */
-uint16_t adcPdcBuff[ADC_BUFFER_SIZE][4];
+/** \brief ADC blocks, PDC fills them in turns. */
+COMPILER_WORD_ALIGNED
+static adc_block_t adcBlocks[ADC_BLOCKS];
+/** \brief Number of reasons PDC must not fill block, it waits for event handler or is
+ *         being sent.
+ */
+static uint8_t adcHeld[ADC_BLOCKS];
+/** \brief Block being filled by PDC. */
+static uint8_t adcFillIdx = 0;
+/** \brief Block PDC continues with, valid if adcNextQueued is set. */
+static uint8_t adcNextIdx = 0;
+/** \brief Indicates next block was given to PDC. */
+static bool adcNextQueued = false;
+/** \brief Indicates PDC has no block, every block is being sent. */
+static bool adcPdcStopped = true;
+/** \brief Samples of block being filled which were already sent as partial frames. */
+static uint32_t adcFlushed = 0;
+/** \brief Time since samples of block being filled were last sent, in ms. */
+static uint16_t adcAge = 0;
+/** \brief Number of completed blocks which wait for event handler. */
+static volatile uint8_t adcPending = 0;
+/** \brief Total number of completed blocks. */
+static volatile uint32_t adcCompleted = 0;
+/** \brief Incremented when PDC restarts, blocks completed before are stale. */
+static volatile uint8_t adcEpoch = 0;
+/** \brief Value of adcEpoch when block was completed. */
+static uint8_t adcBlockEpoch[ADC_BLOCKS];
+/** \brief Incremented when samples are lost, blocks after it are not aligned. */
+static volatile uint8_t adcGaps = 0;
+/** \brief Value of adcGaps when block was completed. */
+static uint8_t adcBlockGaps[ADC_BLOCKS];
+/** \brief Value of adcGaps of the last block processed in coherent averaging. */
+static uint8_t adcLastGaps = 0;
+/** \brief First sample of completed block which was not sent as partial frame. */
+static uint32_t adcBlockFirst[ADC_BLOCKS];
+/** \brief Workspace shared by modes which process blocks. */
+static uint64_t coreWorkspace[CORE_WORKSPACE_SIZE / 8];
 /** \brief DAC PDC variables. */
 Pdc * daccPdc;
 /** \brief DACC PDC packet. */
 pdc_packet_t daccPdcPacket;
-/** \brief Indicates PDC transfer was complete. */
-bool pdcAdcTransfetComplete = 0;
+/** \brief Indicates workspace holds frame which was not sent yet. */
+static bool coreWorkspaceBusy = false;
 
 
 /****************************************************************************************
@@ -55,6 +136,13 @@ bool coreConfigure (daq_settings_t * master_settings)
   {
     /* first copy settings pointer globally. */
     settings = master_settings;
+    /* Everything is sent through transmit arbiter. */
+    txInit(master_settings->dataCom, master_settings->com);
+    coreSelectDataCom();
+    /* Interrupts post events, blocks and data are handled in PendSV. */
+    eventSetHandler(EVENT_ADC_BLOCK, coreProcessBlock);
+    eventSetHandler(EVENT_USB_TX, coreTxReady);
+    eventSetHandler(EVENT_FLUSH, coreFlushPart);
     /* Initialize block size pointer. */
     uint32_t tmp = (uint32_t)master_settings->blockSize;
     master_settings->blockSize = &adcPdcPacket.ul_size;
@@ -101,6 +189,53 @@ bool coreStart(void)
   return true;
 } /*** end of coreInit ***/
 
+/************************************************************************************//**
+** \brief     Counts enabled channels. Sequence ends with first disabled channel.
+** \return    Number of enabled channels.
+**
+****************************************************************************************/
+uint8_t coreGetChannelCount(void)
+{
+  uint8_t count = 0;
+  
+  while((count < 4) && settings->sequence[count])
+  {
+    count++;
+  }
+  return count;
+} /*** end of coreGetChannelCount ***/
+
+/************************************************************************************//**
+** \brief     Selects interface data of the mode is sent to. Text of ASCII, CSV and
+**            deadband modes goes to a serial port, so a terminal shows it and it can be
+**            saved to file as is. Binary frames go to the vendor bulk interface. Called
+**            when mode changes, after frames of previous mode were dropped.
+**
+****************************************************************************************/
+void coreSelectDataCom(void)
+{
+  if((settings->mode == ASCII_MODE) || (settings->mode == CSV_MODE) ||
+     (settings->mode == DEADBAND_MODE))
+  {
+    txSetDataCom(settings->textCom);
+  }
+  else
+  {
+    txSetDataCom(settings->dataCom);
+  }
+} /*** end of coreSelectDataCom ***/
+
+/************************************************************************************//**
+** \brief     Obtains workspace of CORE_WORKSPACE_SIZE bytes. Only the selected mode uses
+**            it, so contents are lost when mode changes.
+** \return    Pointer to the workspace.
+**
+****************************************************************************************/
+void * coreGetWorkspace(void)
+{
+  return coreWorkspace;
+} /*** end of coreGetWorkspace ***/
+
 
 /****************************************************************************************
 *                               A D C   U T I L I T I E S
@@ -203,6 +338,113 @@ void adcSetRes(void)
   else                    ADC->ADC_MR &= ADC_MR_LOWRES;
 } /*** end of DacSetVal ***/
 
+/************************************************************************************//**
+** \brief     Selects timer channel which triggers ADC conversions.
+** \param     dacTimer True to trigger on DAC timer (TC0 channel 1), false for ADC timer.
+**
+****************************************************************************************/
+void adcSetTrigger(bool dacTimer)
+{
+  if(dacTimer) adc_configure_trigger(ADC, ADC_TRIG_TIO_CH_1, 0);
+  else         adc_configure_trigger(ADC, ADC_TRIG_TIO_CH_0, 0);
+} /*** end of adcSetTrigger ***/
+
+/************************************************************************************//**
+** \brief     Restarts ADC PDC transfer, next sample is stored to start of block. Blocks
+**            which were completed before and still wait for event handler are dropped.
+**
+****************************************************************************************/
+void adcRestartPdc(void)
+{
+  irqflags_t flags = cpu_irq_save();
+
+  adcEpoch++;
+  /* Restart is not a gap, blocks start aligned again. */
+  adcLastGaps = adcGaps;
+  adcStartBlock();
+  cpu_irq_restore(flags);
+  pdc_enable_transfer(adcPdc, PERIPH_PTCR_RXTEN);
+} /*** end of adcRestartPdc ***/
+
+/************************************************************************************//**
+** \brief     Gives PDC a free block to fill from its start, next block is queued too.
+**            If every block is being sent, PDC is left without block until the first
+**            one is released. Called with interrupts disabled.
+**
+****************************************************************************************/
+void adcStartBlock(void)
+{
+  pdc_packet_t none = {0, 0};
+
+  adcNextQueued = false;
+  adcPdcStopped = true;
+  adcFlushed = 0;
+  adcAge = 0;
+  for(uint8_t idx = 0; idx < ADC_BLOCKS; idx++)
+  {
+    if(!adcHeld[idx])
+    {
+      adcFillIdx = idx;
+      adcPdcStopped = false;
+      break;
+    }
+  }
+  if(adcPdcStopped)
+  {
+    /* Writing counters clears end of block flag, PDC stays idle. */
+    pdc_rx_init(adcPdc, &none, &none);
+    return;
+  }
+  adcPdcPacket.ul_addr = (uint32_t)adcBlocks[adcFillIdx].samples;
+  pdc_rx_init(adcPdc, &adcPdcPacket, &none);
+  adcQueueNext();
+} /*** end of adcStartBlock ***/
+
+/************************************************************************************//**
+** \brief     Gives PDC the block it continues with after the one being filled, so no
+**            sample is lost between blocks. Called with interrupts disabled.
+**
+****************************************************************************************/
+void adcQueueNext(void)
+{
+  pdc_packet_t next;
+
+  /* Block which completed meanwhile is handled by interrupt first. */
+  if(adcPdcStopped || adcNextQueued || !adcPdc->PERIPH_RCR)
+  {
+    return;
+  }
+  for(uint8_t idx = 0; idx < ADC_BLOCKS; idx++)
+  {
+    if(!adcHeld[idx] && (idx != adcFillIdx))
+    {
+      next.ul_addr = (uint32_t)adcBlocks[idx].samples;
+      next.ul_size = adcPdcPacket.ul_size;
+      /* Samples stored meanwhile show how close PDC was to losing samples. */
+      statusMax(STATUS_REARM_MAX, adcPdcPacket.ul_size - adcPdc->PERIPH_RCR);
+      pdc_rx_init(adcPdc, NULL, &next);
+      TRACE_EVENT(TRACE_ADC_REARM, idx);
+      adcNextIdx = idx;
+      adcNextQueued = true;
+      return;
+    }
+  }
+} /*** end of adcQueueNext ***/
+
+/************************************************************************************//**
+** \brief     Stops acquisition, blocks are completed faster than they are sent.
+**
+****************************************************************************************/
+void adcOverrun(void)
+{
+  statusCount(STATUS_ACQ_STOPS);
+  timerStop();
+  adcHandler(false);
+  settings->acqusitionTime = 1000000;
+  timerSetTimePeriod();
+  txReply((uint8_t *)"Sample rate to high!\n\r", 22);
+} /*** end of adcOverrun ***/
+
 /************************************************************************************//**
 ** \brief     Enable or disable ADC interrupt handler
 ** \param     ADC interrupt handler state
@@ -212,8 +454,7 @@ void adcHandler(bool state)
 {
   if(state)
   {
-    /* Enable the ADC interrupts */
-    adc_enable_interrupt(ADC, ADC_IER_RXBUFF);
+    /* Enable the ADC interrupt, every completed block is handled. */
     adc_enable_interrupt(ADC, ADC_IER_ENDRX);
     /* Set Interrupt Priority */
     NVIC_SetPriority(ADC_IRQn, ADC_IRQ_PRIORITY);
@@ -229,39 +470,190 @@ void adcHandler(bool state)
 } /*** end of adcHandler ***/
 
 /************************************************************************************//**
-** \brief     Analog to digital converter interrupt service routine
+** \brief     Analog to digital converter interrupt service routine. PDC continues with
+**            next block, completed one is held and posted to event handler. Runs at the
+**            top priority and does nothing else.
 **
 ****************************************************************************************/
 void ADC_Handler(void)
 {
   uint32_t status = adc_get_status(ADC);
+  uint8_t idx = adcFillIdx;
+  
+  /* Reading status cleared general overrun, PDC did not read a conversion. */
+  if(status & ADC_ISR_GOVRE)
+  {
+    statusCount(STATUS_ADC_OVERRUNS);
+    adcGaps++;
+  }
+  if(((status & ADC_ISR_ENDRX) != ADC_ISR_ENDRX) || adcPdcStopped)
+  {
+    return;
+  }
+  PROFILE_START();
+  TRACE_EVENT(TRACE_ADC_BLOCK, idx);
+  adcBlockFirst[idx] = adcFlushed;
+  adcBlockEpoch[idx] = adcEpoch;
+  adcBlockGaps[idx] = adcGaps;
+  adcCompleted++;
+  adcFlushed = 0;
+  adcAge = 0;
+  /* PDC already continues with next block if it had one. */
+  if(adcNextQueued)
+  {
+    adcFillIdx = adcNextIdx;
+    adcNextQueued = false;
+  }
+  else
+  {
+    adcPdcStopped = true;
+    statusCount(STATUS_BLOCKS_LOST);
+    /* Samples are lost before the next block. */
+    adcGaps++;
+  }
+  
+  /* Queue is larger than number of blocks, so a held block always fits. */
+  adcHeld[idx]++;
+  adcPending++;
+  eventPost(EVENT_QUEUE_ADC, EVENT_ADC_BLOCK, idx);
   
-  if((status & ADC_ISR_RXBUFF) == ADC_ISR_RXBUFF)
+  if(!adcPdcStopped)
+  {
+    adcQueueNext();
+    if(!adcNextQueued && adcPdc->PERIPH_RCR)
+    {
+      /* Writing next counter clears end of block flag. */
+      adcPdc->PERIPH_RNCR = 0;
+    }
+  }
+  else
+  {
+    /* PDC had no block and samples were lost, it continues if a block is free.
+     * Otherwise event handler restarts it or reports overrun.
+     */
+    adcStartBlock();
+  }
+  PROFILE_STOP(PROFILE_ADC_ISR);
+  
+} /*** end of ADC_Handler ***/
+
+/************************************************************************************//**
+** \brief     Processes completed block in PendSV according to the mode, then gives
+**            it back to PDC unless it is being sent. If PDC is left without block while
+**            no other block waits, blocks are completed faster than they are sent.
+** \param     idx Completed ADC block.
+**
+****************************************************************************************/
+void coreProcessBlock(uint32_t idx)
+{
+  uint16_t *block = (uint16_t *)adcBlocks[idx].samples;
+  irqflags_t flags;
+  bool overrun = false;
+  bool gap;
+  PROFILE_START();
+  TRACE_EVENT(TRACE_BLOCK_START, idx);
+  
+  if(adcBlockEpoch[idx] != adcEpoch)
+  {
+    /* Block completed before PDC restart, it belongs to previous start. */
+    statusCount(STATUS_BLOCKS_STALE);
+  }
+  else if(fraIsActive())
+  {
+    /* Sweep owns the ADC, it sends results by itself. */
+    fraProcess(block);
+  }
+  else if(coherentIsActive())
+  {
+    /* Block is one DAC period, averaged period is sent after the last one. */
+    gap = (adcBlockGaps[idx] != adcLastGaps);
+    adcLastGaps = adcBlockGaps[idx];
+    if(coherentProcess(block, gap))
+    {
+      coherentSend();
+    }
+  }
+  else if(settings->mode == SPECTRUM_MODE)
   {
-    if(!pdcAdcTransfetComplete)
+    /* Block is processed right away, spectrum is sent once enough are averaged. */
+    if(spectrumProcess(block, settings))
     {
-      pdc_rx_init(adcPdc, &adcPdcPacket, NULL);
-      pdc_enable_transfer(adcPdc, PERIPH_PTCR_RXTEN);
+      spectrumSend();
+    }
+  }
+  else if(settings->mode == HISTOGRAM_MODE)
+  {
+    /* Block is added to bins, histogram is sent periodically or on request. */
+    if(histogramProcess(block, settings))
+    {
+      histogramSend();
+    }
+  }
+  else if(settings->mode == CSV_MODE)
+  {
+    /* Block is formatted right away, it is never held and text is streamed. */
+    if(settings->calibration)
+    {
+      calApply(block, *settings->blockSize, settings);
+    }
+    csvProcess(block, settings);
+  }
+  else if(settings->mode == DEADBAND_MODE)
+  {
+    /* Only changed channels are reported, block is never held. */
+    if(settings->calibration)
+    {
+      calApply(block, *settings->blockSize, settings);
+    }
+    deadbandProcess(block, settings);
+  }
+  else if((settings->mode == BIN_MODE) && settings->encoding)
+  {
+    /* Block is packed or compressed right away and sent as one frame. */
+    if(settings->calibration)
+    {
+      calApply(block, *settings->blockSize, settings);
+    }
+    if(coreWorkspaceBusy)
+    {
+      adcOverrun();
     }
     else
     {
-      timerStop();
-      adcHandler(false);
-      pdcAdcTransfetComplete = false;
-      settings->acqusitionTime = 1000000;
-      timerSetTimePeriod();
-      settings->com->len = sprintf((char*)settings->com->buf, "Sample rate to high!\n\r");
-      settings->com->printBuf(settings->com->buf, settings->com->len);
+      uint8_t *frame = packProcess(block, settings);
+      coreWorkspaceBusy = true;
+      if(!txFrame(frame, packGetFrameSize(), NULL, 0, coreWorkspaceSent))
+      {
+        coreWorkspaceBusy = false;
+      }
     }
   }
-  
-  if((status & ADC_ISR_ENDRX) == ADC_ISR_ENDRX)
+  else
   {
-    pdcAdcTransfetComplete = true;
-    settings->com->printBuf(settings->syncBytes, 2);
+    /* Samples are corrected when they are sent, part of them may have been already. */
+    coreSendBlock(idx, adcBlockFirst[idx]);
   }
   
-} /*** end of ADC_Handler ***/
+  flags = cpu_irq_save();
+  adcHeld[idx]--;
+  adcPending--;
+  if(adcPdcStopped)
+  {
+    adcStartBlock();
+    overrun = adcPdcStopped && !adcPending;
+  }
+  else
+  {
+    adcQueueNext();
+  }
+  cpu_irq_restore(flags);
+  if(overrun)
+  {
+    adcOverrun();
+  }
+  TRACE_EVENT(TRACE_BLOCK_END, idx);
+  PROFILE_STOP(PROFILE_BLOCK);
+} /*** end of coreProcessBlock ***/
 
 
 /****************************************************************************************
@@ -323,6 +715,16 @@ void setDacTransferMode(uint8_t val)
   dacc_set_transfer_mode(DACC,	val);
 } /*** end of setDacTransferMode ***/
 
+/************************************************************************************//**
+** \brief     Reads DAC transfer mode back from DAC.
+** \return    0 = half word mode, 1 = word mode.
+**
+****************************************************************************************/
+uint8_t getDacTransferMode(void)
+{
+  return (DACC->DACC_MR & DACC_MR_WORD) ? 1 : 0;
+} /*** end of getDacTransferMode ***/
+
 /************************************************************************************//**
 ** \brief     
 ** \param       
@@ -355,7 +757,9 @@ void DACC_Handler(void)
   /* Confirm that the "end of transmit buffer interrupt" fired */
   if (dacc_get_interrupt_status(DACC) & DACC_ISR_ENDTX)
   {
+    PROFILE_START();
     settings->CurrentRepeats++;
+    TRACE_EVENT(TRACE_DAC_REPEAT, settings->CurrentRepeats);
     /* if NumOfRepeats == 0 -> continuous mode */
     if(settings->CurrentRepeats <= settings->NumOfRepeats || settings->NumOfRepeats == 0)
     {
@@ -366,9 +770,19 @@ void DACC_Handler(void)
       dacTimerStop();
       dacHandler(false);
     }
+    PROFILE_STOP(PROFILE_DACC_ISR);
   }
 } /*** end of DACC_Handler ***/
 
+/************************************************************************************//**
+** \brief     Restarts DAC PDC transfer from the start of LUT.
+**
+****************************************************************************************/
+void dacRestartPdc(void)
+{
+  pdc_tx_init(daccPdc, &daccPdcPacket, &daccPdcPacket);
+} /*** end of dacRestartPdc ***/
+
 /************************************************************************************//**
 ** \brief     
 **            Used to get DAC PDC pointer of the LUT. For changing LUT table on the fly
@@ -396,9 +810,9 @@ bool pdcInit(void)
   /* Only continue if pointer is valid */
   if(adcPdc != NULL)
   {
-    /* Initialize PDC packet. */
-    adcPdcPacket.ul_addr = (uint32_t)&adcPdcBuff;
+    /* Initialize PDC packet, first block is filled right away. */
     adcPdcPacket.ul_size = *settings->blockSize;
+    adcStartBlock();
     pdc_enable_transfer(adcPdc, PERIPH_PTCR_RXTEN);
   }
   else
@@ -453,12 +867,14 @@ bool timerInit(void)
     return false;
   }
   /* Configure TC for timer, waveform generation. */
-  tc_init(TC0, 0, TC_CMR_CPCTRG | TC_CMR_WAVE | TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET);
+  tc_init(TC0, 0, TC_CMR_CPCTRG | TC_CMR_WAVE | TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET |
+                  TC_CMR_ASWTRG_CLEAR);
   /* For DAC */
   tc_init(TC0, 1, TC_CMR_TCCLKS_TIMER_CLOCK3 | //MCK/32 -> 1Mhz
                   TC_CMR_WAVE |                //waveform mode
                   TC_CMR_WAVSEL_UP_RC |        //count up, reset on RC match
-                  TC_CMR_ACPC_TOGGLE           //toggle TIOA on RC match
+                  TC_CMR_ACPC_TOGGLE |         //toggle TIOA on RC match
+                  TC_CMR_ASWTRG_CLEAR          //clear TIOA on start
   );
   /* Sets timer counter period. */
   if(!timerSetTimePeriod())
@@ -567,69 +983,374 @@ void dacTimerStart(void)
   tc_start(TC0, 1);
 } /*** end of dacTimerStart ***/
 
+/************************************************************************************//**
+** \brief     Starts ADC and DAC timer with the same synchronous trigger. Both PDC
+**            transfers are restarted, so first ADC sample is stored to start of block
+**            and first DAC value is first LUT value.
+** \param     adcDelay Time from start to first ADC trigger in nanoseconds.
+** \param     dacDelay Time from start to first DAC trigger in nanoseconds.
+**
+****************************************************************************************/
+void timerSyncStart(uint32_t *adcDelay, uint32_t *dacDelay)
+{
+  timerStop();
+  dacTimerStop();
+  settings->CurrentRepeats = 0;
+  adcRestartPdc();
+  dacRestartPdc();
+  adcHandler(true);
+  dacHandler(true);
+  
+  /* Channels are started one by one, sync trigger resets both counters at once. */
+  cpu_irq_enter_critical();
+  tc_start(TC0, 0);
+  tc_start(TC0, 1);
+  tc_sync_trigger(TC0);
+  cpu_irq_leave_critical();
+  
+  /* TIOA is cleared on start, first rising edge is at first RC compare. */
+  *adcDelay = timerGetFirstEdge(0);
+  *dacDelay = timerGetFirstEdge(1);
+} /*** end of timerSyncStart ***/
+
+/************************************************************************************//**
+** \brief     Calculates time from start of timer channel to its first RC compare.
+** \param     channel TC0 channel.
+** \return    Time in nanoseconds.
+**
+****************************************************************************************/
+uint32_t timerGetFirstEdge(uint32_t channel)
+{
+  /* Prescalers of TIMER_CLOCK1 to TIMER_CLOCK4. */
+  const uint32_t divisors[4] = {2, 8, 32, 128};
+  uint32_t clks = TC0->TC_CHANNEL[channel].TC_CMR & TC_CMR_TCCLKS_Msk;
+  uint64_t ticks = tc_read_rc(TC0, channel);
+  uint32_t clkHz;
+  
+  if(clks < 4)
+  {
+    clkHz = sysclk_get_cpu_hz() / divisors[clks];
+  }
+  else
+  {
+    /* TIMER_CLOCK5 is slow clock */
+    clkHz = BOARD_FREQ_SLCK_XTAL;
+  }
+  return (uint32_t)((ticks * (uint64_t)1000000000) / clkHz);
+} /*** end of timerGetFirstEdge ***/
+
 
 /****************************************************************************************
 *                        C A L L B A C K   F U N C T I O N S
 ****************************************************************************************/
 /************************************************************************************//**
-** \brief     This is a callback function and it is called when tx buffer is empty.
+** \brief     Called when interface sent data, next data is sent through transmit
+**            arbiter from PendSV.
 **
 ****************************************************************************************/
 void comTxEmptyCallback(void)
 {
-  if(pdcAdcTransfetComplete)
+  PROFILE_START();
+  TRACE_EVENT(TRACE_TX_DONE, 0);
+  eventPostOnce(EVENT_QUEUE_USB, EVENT_USB_TX);
+  PROFILE_STOP(PROFILE_TX_EMPTY);
+} /*** end of comTxEmptyCallback ***/
+
+/************************************************************************************//**
+** \brief     Handles event posted by transmit empty callback, interface has room for
+**            more data.
+** \param     par Not used.
+**
+****************************************************************************************/
+void coreTxReady(uint32_t par)
+{
+  txPump();
+} /*** end of coreTxReady ***/
+
+/************************************************************************************//**
+** \brief     Queues completed block as one frame after its sync bytes, as 16-bit words
+**            in BIN mode and as text otherwise. Raw block is sent as is, sync bytes are
+**            written to its header slot and PDC does not fill it until it is sent. Text
+**            and averages are prepared in workspace right away. If part of the block
+**            was already sent, the rest is sent as partial frame. Samples are corrected
+**            here or by coreSendPart, never twice.
+** \param     idx Completed ADC block.
+** \param     first First sample which was not sent yet.
+**
+****************************************************************************************/
+void coreSendBlock(uint8_t idx, uint32_t first)
+{
+  uint8_t *out = (uint8_t *)coreGetWorkspace();
+  uint16_t *words = (uint16_t *)coreGetWorkspace();
+  uint16_t *block = (uint16_t *)adcBlocks[idx].samples;
+  uint8_t *frame = &adcBlocks[idx].header[ADC_HEADER_SLOT - 2];
+  uint32_t len = *(settings->blockSize)*2;
+  irqflags_t flags;
+
+  if(first)
   {
-    if(settings->mode == BIN_MODE)
+    if((first < *settings->blockSize) &&
+       !coreSendPart(&block[first], *settings->blockSize - first))
     {
-      if(settings->averaging > 1)
-      {
-        for(uint16_t j = 0; j < *settings->blockSize; j += settings->averaging)
-        {
-          uint32_t measurment[4];
-          for(uint8_t ch = 0; ((ch < 4) && settings->sequence[ch]); ch++)
-          {
-            for(uint16_t i = ch + j; i < (ch + j + settings->averaging); i += 4)
-            {
-              measurment[ch] += (adcPdcBuff[i][ch] & 0x0FFF);
-            }
-            measurment[ch] /= settings->averaging;
-            adcPdcBuff[0][ch] = measurment[ch] | (adcPdcBuff[0][ch] & 0xF000);
-          }
-          settings->com->printBuf((uint8_t *)adcPdcBuff, 4*2);
-        }          
-      }
-      else
+      adcOverrun();
+    }
+    return;
+  }
+  /* Correct samples before they are sent. */
+  if(settings->calibration)
+  {
+    calApply(block, *settings->blockSize, settings);
+  }
+  if((settings->mode == BIN_MODE) && (settings->averaging <= 1))
+  {
+    frame[0] = settings->syncBytes[0];
+    frame[1] = settings->syncBytes[1];
+    /* Frame may be sent and released right away. */
+    flags = cpu_irq_save();
+    adcHeld[idx]++;
+    cpu_irq_restore(flags);
+    if(!txBlock(frame, len + 2, coreBlockSent))
+    {
+      flags = cpu_irq_save();
+      adcHeld[idx]--;
+      cpu_irq_restore(flags);
+    }
+    return;
+  }
+  /* Frame of previous block still uses workspace. */
+  if(coreWorkspaceBusy)
+  {
+    adcOverrun();
+    return;
+  }
+  if(settings->mode != BIN_MODE)
+  {
+    /* Text of the whole block is formatted to workspace. */
+    len = asciiFormatBlock(block, *settings->blockSize, settings, out);
+  }
+  else
+  {
+    len = coreAverageBlock(block, *settings->blockSize, words);
+  }
+  coreWorkspaceBusy = true;
+  if(!txFrame(settings->syncBytes, 2, out, len, coreWorkspaceSent))
+  {
+    coreWorkspaceBusy = false;
+  }
+} /*** end of coreSendBlock ***/
+
+/************************************************************************************//**
+** \brief     Queues part of a block as one frame, prepared in workspace. Sync bytes hold
+**            number of samples of the part and CORE_SYNC_PARTIAL, data is in the same
+**            format as of a whole block. Samples are corrected in place, so the rest of
+**            a block is corrected like its parts sent before.
+** \param     samples First sample of the part.
+** \param     count Number of samples.
+** \return    True if successful, false if workspace is in use.
+**
+****************************************************************************************/
+bool coreSendPart(uint16_t *samples, uint32_t count)
+{
+  uint8_t *out = (uint8_t *)coreGetWorkspace();
+  /* Data follows sync bytes, one word into workspace. */
+  uint16_t *words = (uint16_t *)coreGetWorkspace() + 1;
+  uint32_t len = count*2;
+
+  if(coreWorkspaceBusy)
+  {
+    return false;
+  }
+  /* Samples are corrected in place, PDC has already moved past them. */
+  if(settings->calibration)
+  {
+    calApply(samples, count, settings);
+  }
+  out[0] = ( (uint16_t)count       & 0b1111111) | 0b10000000;
+  out[1] = (((uint16_t)count >> 7) & 0b1111111) | 0b10000000 | CORE_SYNC_PARTIAL;
+  if(settings->mode != BIN_MODE)
+  {
+    len = asciiFormatBlock(samples, count, settings, &out[2]);
+  }
+  else if(settings->averaging > 1)
+  {
+    len = coreAverageBlock(samples, count, words);
+  }
+  else
+  {
+    memcpy(&out[2], samples, len);
+  }
+  coreWorkspaceBusy = true;
+  if(!txFrame(out, len + 2, NULL, 0, coreWorkspaceSent))
+  {
+    coreWorkspaceBusy = false;
+  }
+  return true;
+} /*** end of coreSendPart ***/
+
+/************************************************************************************//**
+** \brief     Obtains number of samples which make one output line or averaged row, part
+**            of a block is sent in whole rows only.
+** \return    Number of samples, 0 if no channel is enabled.
+**
+****************************************************************************************/
+uint32_t coreGetRowSize(void)
+{
+  uint32_t avg = (settings->averaging > 1) ? settings->averaging : 1;
+
+  return coreGetChannelCount() * avg;
+} /*** end of coreGetRowSize ***/
+
+/************************************************************************************//**
+** \brief     Averages every channel over groups of settings->averaging rows, channel
+**            tag of the first row is kept.
+** \param     block Pointer to completed ADC block.
+** \param     size Number of samples, block size or less for part of a block.
+** \param     out Averaged rows.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t coreAverageBlock(uint16_t *block, uint32_t size, uint16_t *out)
+{
+  uint8_t chCount = coreGetChannelCount();
+  uint16_t count = settings->averaging;
+  uint32_t rows, sum, len = 0;
+
+  if(!chCount)
+  {
+    return 0;
+  }
+  PROFILE_START();
+  rows = size / chCount;
+  for(uint32_t row = 0; row + count <= rows; row += count)
+  {
+    for(uint8_t ch = 0; ch < chCount; ch++)
+    {
+      sum = 0;
+      for(uint16_t i = 0; i < count; i++)
       {
-        settings->com->printBuf((uint8_t *)adcPdcBuff, *(settings->blockSize)*2);
+        sum += block[(row + i)*chCount + ch] & 0x0FFF;
       }
+      out[len++] = (uint16_t)((sum + count/2) / count) |
+                   (block[row*chCount + ch] & 0xF000);
+    }
+  }
+  PROFILE_STOP(PROFILE_AVERAGE);
+  return len * 2;
+} /*** end of coreAverageBlock ***/
+
+/************************************************************************************//**
+** \brief     Called when raw block was sent or dropped, the block the frame belongs to
+**            is given back to PDC. Blocks may be released out of order when frames
+**            are dropped.
+** \param     buf Start of the frame, sync bytes in front of block samples.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void coreBlockSent(uint8_t *buf, uint32_t len)
+{
+  irqflags_t flags = cpu_irq_save();
+
+  for(uint8_t idx = 0; idx < ADC_BLOCKS; idx++)
+  {
+    if(buf == &adcBlocks[idx].header[ADC_HEADER_SLOT - 2])
+    {
+      adcHeld[idx]--;
+      break;
+    }
+  }
+  if(adcPdcStopped)
+  {
+    adcStartBlock();
+  }
+  else
+  {
+    adcQueueNext();
+  }
+  cpu_irq_restore(flags);
+} /*** end of coreBlockSent ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when frame prepared in workspace was sent, next
+**            block may use workspace.
+** \param     buf Start of the frame.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void coreWorkspaceSent(uint8_t *buf, uint32_t len)
+{
+  coreWorkspaceBusy = false;
+} /*** end of coreWorkspaceSent ***/
+
+/************************************************************************************//**
+** \brief     Called by USB device stack every 1 ms. Once samples waited in a block which
+**            is not complete for settings->blockLatency, PendSV sends them as partial
+**            frame. Packed and compressed blocks and modes which process blocks wait for
+**            whole blocks.
+**
+****************************************************************************************/
+void coreSofCallback(void)
+{
+  statusTick();
+  if((settings == NULL) || (adcPdc == NULL) || !settings->blockLatency ||
+     fraIsActive() || coherentIsActive() ||
+     ((settings->mode != ASCII_MODE) && (settings->mode != BIN_MODE)) ||
+     ((settings->mode == BIN_MODE) && settings->encoding))
+  {
+    return;
+  }
+  if(!adcPdcStopped && (++adcAge >= settings->blockLatency))
+  {
+    adcAge = 0;
+    eventPostOnce(EVENT_QUEUE_USB, EVENT_FLUSH);
+  }
+} /*** end of coreSofCallback ***/
+
+/************************************************************************************//**
+** \brief     Sends samples stored by PDC so far in block being filled as partial frame.
+**            PDC keeps filling the block, it is only read. Completed blocks which wait
+**            for event handler are sent first, so nothing is sent while any waits.
+** \param     par Not used.
+**
+****************************************************************************************/
+void coreFlushPart(uint32_t par)
+{
+  irqflags_t flags = cpu_irq_save();
+  uint8_t idx = adcFillIdx;
+  uint32_t completed = adcCompleted;
+  uint32_t first = adcFlushed;
+  uint32_t start = (uint32_t)adcBlocks[idx].samples;
+  uint32_t written = adcPdcPacket.ul_size - pdc_read_rx_counter(adcPdc);
+  uint32_t rpr = adcPdc->PERIPH_RPR;
+  uint32_t unit = coreGetRowSize();
+
+  /* PDC may have moved to next block, end of block interrupt sends this one. */
+  if(adcPdcStopped || adcPending || !unit || (written >= adcPdcPacket.ul_size) ||
+     (rpr < start) || (rpr > start + adcPdcPacket.ul_size*2))
+  {
+    cpu_irq_restore(flags);
+    return;
+  }
+  cpu_irq_restore(flags);
+  PROFILE_START();
+  written -= written % unit;
+  TRACE_EVENT(TRACE_FLUSH, written - first);
+  if((written > first) &&
+     coreSendPart(&((uint16_t *)adcBlocks[idx].samples)[first], written - first))
+  {
+    /* Block may have completed meanwhile, its rest is sent from there. */
+    flags = cpu_irq_save();
+    if(completed == adcCompleted)
+    {
+      adcFlushed = written;
     }
     else
     {
-      uint32_t measurment;
-      for(uint8_t ch = 0; ((ch < 4) && settings->sequence[ch]); ch++)
-      {
-        measurment = (adcPdcBuff[0][ch] & 0x0FFF);
-        if(settings->averaging > 1)
-        {
-          for(uint16_t i = 1; i < settings->averaging; i++)
-          {
-            measurment += (adcPdcBuff[i][ch] & 0x0FFF);
-          }
-          measurment /= settings->averaging;
-        }
-        measurment *= 20000;
-        measurment /= 4095;
-        measurment = 10000 - measurment;
-        settings->com->len = sprintf((char*)settings->com->buf, "CH%u: %+ 6.0fmV, ",
-                                     settings->sequence[ch], (measurment - 10000.0));
-        settings->com->printBuf(settings->com->buf, settings->com->len);
-      }
-      settings->com->len = sprintf((char*)settings->com->buf, "\n\r");
-      settings->com->printBuf(settings->com->buf, settings->com->len);
+      adcBlockFirst[idx] = written;
     }
-    pdcAdcTransfetComplete = false;
+    cpu_irq_restore(flags);
   }
-} /*** end of comTxEmptyCallback ***/
+  PROFILE_STOP(PROFILE_FLUSH);
+} /*** end of coreFlushPart ***/
 
 /************************************************************************************//**
 ** \brief    
@@ -22,11 +22,25 @@
 /** \brief Logic state false value */
 #define TRUE                1
 
+/* Interrupt priorities, lower value preempts higher one. PDC is re-armed at the top
+ * priority and nothing else is done there. USB stack only moves data between its
+ * buffers and endpoints. Events posted by both are handled in PendSV at the lowest
+ * priority, its critical sections mask USB and PendSV only (see eventLock).
+ */
+/** \brief IRQ priority of ADC, PDC continues with next block */
+#define ADC_IRQ_PRIORITY    0
+/** \brief IRQ priority of DACC, PDC starts LUT again */
+#define DACC_IRQ_PRIORITY   0
+/** \brief IRQ priority for timer */
+#define TIMER_IRQ_PRIORITY  1
+/** \brief IRQ priority of USB device, used as UDD_USB_INT_LEVEL */
+#define USB_IRQ_PRIORITY    2
+/** \brief Priority of PendSV which runs event handlers */
+#define EVENT_IRQ_PRIORITY  15
+
 /* ADC configuration */
 /** \brief clock for ADC converter */
 #define ADC_CLK             16000000
-/** \brief IRQ priority for timer */
-#define ADC_IRQ_PRIORITY    4
 /** \brief ADC gain 0.5 register value */
 #define ADC_GAIN_0_5        0
 /** \brief ADC gain 1.0 register value */
@@ -43,6 +57,20 @@
 #define DAQ_CH_4_ADC_CH     2
 /** \brief Size of ADC buffer for measurments */
 #define ADC_BUFFER_SIZE     256
+/** \brief Number of ADC blocks, PDC fills the next one while a block waits for event
+ *         handler or is sent.
+ */
+#define ADC_BLOCKS          3
+/** \brief Bytes reserved before every ADC block, frame header is written there */
+#define ADC_HEADER_SLOT     4
+/** \brief Set in second sync byte of a frame with part of a block */
+#define CORE_SYNC_PARTIAL   0x40
+/** \brief Longest time samples wait in a block which is not complete, in ms */
+#define CORE_BLOCK_LATENCY_MAX 60000
+/** \brief Size of workspace in bytes. Modes use it one at a time (spectrum, histogram,
+ *         coherent averaging, text output).
+ */
+#define CORE_WORKSPACE_SIZE 12288
 
 /* DAC configuration */
 /** \brief DAQ DAC chanell 1 to uC DACC chanell map */
@@ -51,14 +79,10 @@
 #define DACC_CHANNEL1       1
 /** \brief Size of DAC buffer for look up table */
 #define DACC_BUFFER_SIZE    1024
-/** \brief IRQ priority for timer */
-#define DACC_IRQ_PRIORITY   4
 
 /* TIMER configuration */
 /** \brief channel# of used timer */
 #define TIMER_CH            0
-/** \brief IRQ priority for timer */
-#define TIMER_IRQ_PRIORITY  4
 /** \brief maximum value of timer */
 #define TIMER_MAX           50000
 /** \brief division factor to convert from microseconds */
@@ -75,6 +99,16 @@
 #define ASCII_MODE          0
 /** \brief Parameter BIN mode value */
 #define BIN_MODE            1
+/** \brief Parameter spectrum mode value */
+#define SPECTRUM_MODE       2
+/** \brief Parameter coherent averaging mode value */
+#define COHERENT_MODE       3
+/** \brief Parameter histogram mode value */
+#define HISTOGRAM_MODE      4
+/** \brief Parameter CSV streaming mode value */
+#define CSV_MODE            5
+/** \brief Parameter report by exception mode value */
+#define DEADBAND_MODE       6
 
 
 /****************************************************************************************
@@ -106,7 +140,22 @@ typedef struct                       /* DAQ settings type
   uint16_t LutLength;                /* How many values does LUT have                  */
   uint16_t NumOfRepeats;             /* Number of LUT repeats, 0 = continuous, 65k max */
   uint16_t CurrentRepeats;           /* Current number of LUT repeats                  */
+  uint16_t fftPoints;                /* Number of FFT points in spectrum mode          */
+  uint8_t spectrumType;              /* Spectrum output. Magnitude=0, power=1          */
+  uint16_t spectrumAverages;         /* Number of spectra averaged before sending      */
+  uint16_t histogramPeriod;          /* Blocks between histograms, 0 = on request only */
+  uint8_t calibration;               /* Sample correction. Off=0, on=1                 */
+  uint8_t asciiUnit;                 /* Text output unit. Millivolts=0, microvolts=1   */
+  uint8_t asciiSeparator;            /* Text output separator. Space=0, comma=1        */
+  uint8_t csvIndex;                  /* CSV sample index column. Off=0, on=1           */
+  uint8_t encoding;                  /* BIN sample encoding. Words=0, packed=1         */
+  uint16_t deadband;                 /* Reported change in 12-bit codes                */
+  uint32_t heartbeat;                /* Seconds between reports of all channels, 0=off */
+  uint16_t latency;                  /* Time data waits to fill USB transfer, in ms    */
+  uint16_t blockLatency;             /* Time samples wait for block to complete, 0=off */
   COM_t *com;                        /* Pointer to the linked communication interface  */
+  COM_t *textCom;                    /* Interface data of text modes is sent to        */
+  COM_t *dataCom;                    /* Interface binary data is sent to               */
 }daq_settings_t;
 
 
@@ -116,9 +165,13 @@ typedef struct                       /* DAQ settings type
 /* Core functions */
 bool coreConfigure (daq_settings_t * master_settings);
 bool coreStart(void);
+uint8_t coreGetChannelCount(void);
+void coreSelectDataCom(void);
+void * coreGetWorkspace(void);
 
 /* Communication callback function pointer. */
 void * coreGetTxEmptyCallBackPtr(void);
+void coreSofCallback(void);
 
 /* Timer core handlers. */
 bool timerSetTimePeriod(void);
@@ -126,19 +179,26 @@ void timerStart(void);
 void timerStop(void);
 void dacTimerStart(void);
 void dacTimerStop(void);
+void timerSyncStart(uint32_t *adcDelay, uint32_t *dacDelay);
+uint32_t timerGetFirstEdge(uint32_t channel);
 
 /* ADC core handlers. */
 void adcHandler(bool state);
 void adcSetRes(void);
 void adcSetGain(void);
 void adcSetChannels(void);
+void adcSetTrigger(bool dacTimer);
+void adcRestartPdc(void);
 bool DacSetTimer(void);
 
 /* DAC core handlers. */
+void dacHandler(bool state);
 void setDacPeriod(void);
 void SetDacPdcLength(void);
 void setDacTransferMode(uint8_t val);
+uint8_t getDacTransferMode(void);
 uint32_t GetLutCntr(void);
+void dacRestartPdc(void);
 
 
 #endif /* CORE_H_ */
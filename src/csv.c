@@ -0,0 +1,249 @@
+/************************************************************************************//**
+* \file     csv.c
+* \brief    This module implements full rate CSV streaming mode of the DAQ. Blocks are
+*           formatted in PendSV to a text ring in core workspace, PDC never waits for
+*           them. Text of every block is queued to transmit arbiter as one frame, CDC
+*           driver of the text port packs it into whole packets and sends the rest on
+*           the next start of frame.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "csv.h"                     /* CSV streaming mode                             */
+#include "event.h"                   /* Event queues                                   */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Text waiting to be sent in workspace. */
+#define CSV_TEXT            ((uint8_t *)coreGetWorkspace())
+
+#if CSV_BUFFER_SIZE > CORE_WORKSPACE_SIZE
+#error "CSV text buffer does not fit to core workspace"
+#endif
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Index of the next sample row. */
+static uint32_t csvIndex = 0;
+/** \brief Total number of bytes written to text buffer. */
+static volatile uint32_t csvTail = 0;
+/** \brief Total number of bytes queued to transmit arbiter. */
+static volatile uint32_t csvQueued = 0;
+/** \brief Total number of bytes sent from text buffer. */
+static volatile uint32_t csvHead = 0;
+/** \brief Number of rows dropped because text buffer was full. */
+static volatile uint32_t csvOverruns = 0;
+
+
+/****************************************************************************************
+*                                 C S V   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Drops text which was not sent yet and starts index from 0.
+**
+****************************************************************************************/
+void csvReset(void)
+{
+  uint32_t flags = eventLock();
+
+  csvIndex = 0;
+  csvTail = 0;
+  csvQueued = 0;
+  csvHead = 0;
+  csvOverruns = 0;
+  eventUnlock(flags);
+} /*** end of csvReset ***/
+
+/************************************************************************************//**
+** \brief     Formats every row of completed block to a CSV line and queues the lines
+**            as one frame, so command replies never split a line. Called from block
+**            event in PendSV, the block is copied out as text before it is given back
+**            to PDC. Rows which do not fit to text buffer are dropped, their index is
+**            skipped.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+**
+****************************************************************************************/
+void csvProcess(uint16_t *block, daq_settings_t *settings)
+{
+  uint8_t line[CSV_LINE_SIZE];
+  uint8_t chCount = coreGetChannelCount();
+  /* 10-bit codes are converted as 12-bit codes, both with 6 fractional bits. */
+  uint8_t shift = settings->ADClowRes ? 8 : 6;
+  /* Gain of every ADC channel, samples are tagged with it. */
+  uint8_t gain[8];
+  uint32_t rows;
+  uint8_t len;
+  uint16_t sample;
+  int32_t val;
+
+  if(!chCount)
+  {
+    return;
+  }
+  rows = *settings->blockSize / chCount;
+  asciiGetGains(settings, gain);
+
+  for(uint32_t row = 0; row < rows; row++)
+  {
+    len = 0;
+    if(settings->csvIndex)
+    {
+      len += csvFormatIndex(csvIndex, &line[len]);
+      line[len++] = ',';
+    }
+    for(uint8_t ch = 0; ch < chCount; ch++)
+    {
+      sample = block[row*chCount + ch];
+      val = asciiCodeToValue((uint32_t)(sample & 0x0FFF) << shift,
+                             gain[(sample >> 12) & 0x07], settings->asciiUnit);
+      len += asciiFormatValue(val, 0, &line[len]);
+      line[len++] = (ch < chCount - 1) ? ',' : '\r';
+    }
+    line[len++] = '\n';
+
+    /* Drop rest of the block if host does not keep up. */
+    if(!csvAppend(line, len))
+    {
+      csvOverruns += rows - row;
+      csvIndex += rows - row;
+      break;
+    }
+    csvIndex++;
+  }
+
+  csvSend();
+} /*** end of csvProcess ***/
+
+/************************************************************************************//**
+** \brief     Adds line to text buffer. Called from PendSV only.
+** \param     line Text.
+** \param     len Length of text.
+** \return    True if successful, false if text buffer is full.
+**
+****************************************************************************************/
+bool csvAppend(uint8_t *line, uint8_t len)
+{
+  uint8_t *text = CSV_TEXT;
+
+  if(len > CSV_BUFFER_SIZE - (csvTail - csvHead))
+  {
+    return false;
+  }
+  for(uint8_t i = 0; i < len; i++)
+  {
+    text[(csvTail + i) & (CSV_BUFFER_SIZE - 1)] = line[i];
+  }
+  csvTail += len;
+  return true;
+} /*** end of csvAppend ***/
+
+/************************************************************************************//**
+** \brief     Queues text added since last call to transmit arbiter, in two parts if it
+**            wraps around the end of the buffer. Text always ends with a whole line and
+**            is not split to packets here, the CDC driver does that. If frame queue is
+**            full, text waits for the next call. Called from PendSV, for every block
+**            and when acquisition is stopped.
+**
+****************************************************************************************/
+void csvSend(void)
+{
+  uint32_t flags = eventLock();
+  uint32_t len = csvTail - csvQueued;
+  uint32_t start = csvQueued & (CSV_BUFFER_SIZE - 1);
+  uint32_t part = CSV_BUFFER_SIZE - start;
+
+  if(part > len)
+  {
+    part = len;
+  }
+  if(len && txFrame(&CSV_TEXT[start], part, CSV_TEXT, len - part, csvSent))
+  {
+    csvQueued += len;
+  }
+  eventUnlock(flags);
+} /*** end of csvSend ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when lines were sent, their room is released.
+** \param     buf Start of the sent text.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void csvSent(uint8_t *buf, uint32_t len)
+{
+  csvHead += len;
+} /*** end of csvSent ***/
+
+/************************************************************************************//**
+** \brief     Obtains shortest sample period the host can keep up with in CSV mode for
+**            current channels, unit and index setting. Longest values are assumed.
+** \param     settings Pointer to DAQ settings.
+** \return    Sample period in us.
+**
+****************************************************************************************/
+uint32_t csvGetMinPeriod(daq_settings_t *settings)
+{
+  uint8_t width = settings->asciiUnit ? ASCII_WIDTH_UV : ASCII_WIDTH_MV;
+  /* Every value has a comma or line end, line end is two characters. */
+  uint32_t len = coreGetChannelCount() * (width + 1) + 1;
+
+  if(settings->csvIndex)
+  {
+    len += CSV_INDEX_WIDTH;
+  }
+  return (len * 1000000 + CSV_THROUGHPUT - 1) / CSV_THROUGHPUT;
+} /*** end of csvGetMinPeriod ***/
+
+/************************************************************************************//**
+** \brief     Obtains number of rows dropped since CSV mode was reset.
+** \return    Number of dropped rows.
+**
+****************************************************************************************/
+uint32_t csvGetOverruns(void)
+{
+  return csvOverruns;
+} /*** end of csvGetOverruns ***/
+
+/************************************************************************************//**
+** \brief     Formats unsigned index.
+** \param     index Index.
+** \param     out Text buffer.
+** \return    Number of written characters.
+**
+****************************************************************************************/
+uint8_t csvFormatIndex(uint64_t index, uint8_t *out)
+{
+  uint8_t digits[20];
+  uint8_t count = 0;
+  uint8_t len = 0;
+  uint32_t low;
+
+  /* 64-bit division is slow, it is used only while index does not fit 32 bits. */
+  while(index > 0xFFFFFFFF)
+  {
+    digits[count++] = '0' + (uint8_t)(index % 10);
+    index /= 10;
+  }
+  low = (uint32_t)index;
+  do
+  {
+    digits[count++] = '0' + (low % 10);
+    low /= 10;
+  } while(low);
+
+  while(count)
+  {
+    out[len++] = digits[--count];
+  }
+  return len;
+} /*** end of csvFormatIndex ***/
+
+
+/************************************* end of csv.c ************************************/
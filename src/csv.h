@@ -0,0 +1,53 @@
+/************************************************************************************//**
+* \file     csv.h
+* \brief    This module implements full rate CSV streaming mode of the DAQ.
+****************************************************************************************/
+#ifndef CSV_H_
+#define CSV_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "ascii.h"                   /* Text output                                    */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* CSV index command values */
+/** \brief Lines hold values only */
+#define CSV_INDEX_OFF       0
+/** \brief Lines start with sample index */
+#define CSV_INDEX_ON        1
+
+/** \brief Size of text buffer in workspace, power of 2 */
+#define CSV_BUFFER_SIZE     8192
+/** \brief Longest line, index and 4 values in microvolts */
+#define CSV_LINE_SIZE       64
+/** \brief Longest index with comma */
+#define CSV_INDEX_WIDTH     11
+/** \brief Sustained CDC throughput in bytes per second, used for the rate limit.
+ *         Full speed bulk is 1216000 at most, hosts usually read about 800000.
+ */
+#define CSV_THROUGHPUT      800000
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void csvReset(void);
+void csvProcess(uint16_t *block, daq_settings_t *settings);
+bool csvAppend(uint8_t *line, uint8_t len);
+void csvSend(void);
+void csvSent(uint8_t *buf, uint32_t len);
+uint32_t csvGetMinPeriod(daq_settings_t *settings);
+uint32_t csvGetOverruns(void);
+uint8_t csvFormatIndex(uint64_t index, uint8_t *out);
+
+
+#endif /* CSV_H_ */
+/************************************* end of csv.h ************************************/
@@ -0,0 +1,124 @@
+/************************************************************************************//**
+* \file     deadband.c
+* \brief    This module implements report by exception mode of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "deadband.h"                /* Report by exception mode                       */
+#include "event.h"                   /* Event queues                                   */
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Last reported 12-bit code of every channel in a row. */
+static uint16_t deadbandLast[4];
+/** \brief Indicates channels were reported at least once. */
+static bool deadbandValid = false;
+/** \brief Index of the next sample row since start, 64 bits never wrap. */
+static uint64_t deadbandIndex = 0;
+/** \brief Rows since last heartbeat. */
+static uint32_t deadbandRows = 0;
+
+
+/****************************************************************************************
+*                            D E A D B A N D   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Starts time from 0, every channel is reported with the next row.
+**
+****************************************************************************************/
+void deadbandReset(void)
+{
+  uint32_t flags = eventLock();
+
+  deadbandValid = false;
+  deadbandIndex = 0;
+  deadbandRows = 0;
+  eventUnlock(flags);
+} /*** end of deadbandReset ***/
+
+/************************************************************************************//**
+** \brief     Reports every sample of completed block which is further than deadband
+**            from the last reported value of its channel, as line "time,channel,value"
+**            with time in ms since start. Every heartbeat period all channels are
+**            reported. Lines are sent right away through CSV text buffer. Lines which
+**            do not fit are reported again with a later sample.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+**
+****************************************************************************************/
+void deadbandProcess(uint16_t *block, daq_settings_t *settings)
+{
+  uint8_t line[CSV_LINE_SIZE];
+  uint8_t chCount = coreGetChannelCount();
+  /* 10-bit codes are compared as 12-bit codes. */
+  uint8_t shift = settings->ADClowRes ? 2 : 0;
+  /* Gain of every ADC channel, samples are tagged with it. */
+  uint8_t gain[8];
+  uint32_t rows, heartbeatRows = 0;
+  uint64_t time;
+  uint16_t sample, code, diff;
+  bool heartbeat, sent = false;
+  uint8_t len;
+
+  if(!chCount)
+  {
+    return;
+  }
+  rows = *settings->blockSize / chCount;
+  asciiGetGains(settings, gain);
+  if(settings->heartbeat)
+  {
+    heartbeatRows = (uint32_t)(((uint64_t)settings->heartbeat * 1000000) /
+                               settings->acqusitionTime);
+  }
+
+  for(uint32_t row = 0; row < rows; row++, deadbandIndex++, deadbandRows++)
+  {
+    heartbeat = !deadbandValid || (heartbeatRows && (deadbandRows >= heartbeatRows));
+    if(heartbeat)
+    {
+      deadbandRows = 0;
+    }
+    for(uint8_t ch = 0; ch < chCount; ch++)
+    {
+      sample = block[row*chCount + ch];
+      code = (sample & 0x0FFF) << shift;
+      diff = (code > deadbandLast[ch]) ? (code - deadbandLast[ch]) :
+                                          (deadbandLast[ch] - code);
+      if(!heartbeat && (diff <= settings->deadband))
+      {
+        continue;
+      }
+      time = (deadbandIndex * settings->acqusitionTime) / 1000;
+      len = csvFormatIndex(time, line);
+      line[len++] = ',';
+      line[len++] = '0' + settings->sequence[ch];
+      line[len++] = ',';
+      len += asciiFormatValue(asciiCodeToValue((uint32_t)code << 6,
+                                               gain[(sample >> 12) & 0x07],
+                                               settings->asciiUnit), 0, &line[len]);
+      line[len++] = '\r';
+      line[len++] = '\n';
+      /* Not reported channel is compared to old value again. */
+      if(csvAppend(line, len))
+      {
+        deadbandLast[ch] = code;
+        sent = true;
+      }
+    }
+    deadbandValid = true;
+  }
+
+  if(sent)
+  {
+    csvSend();
+  }
+} /*** end of deadbandProcess ***/
+
+
+/********************************** end of deadband.c **********************************/
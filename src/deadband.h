@@ -0,0 +1,35 @@
+/************************************************************************************//**
+* \file     deadband.h
+* \brief    This module implements report by exception mode of the DAQ.
+****************************************************************************************/
+#ifndef DEADBAND_H_
+#define DEADBAND_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "ascii.h"                   /* Text output                                    */
+#include "csv.h"                     /* CSV streaming mode                             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Largest deadband in 12-bit codes */
+#define DEADBAND_MAX        4095
+/** \brief Longest heartbeat period in seconds */
+#define DEADBAND_HEARTBEAT_MAX 86400
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void deadbandReset(void);
+void deadbandProcess(uint16_t *block, daq_settings_t *settings);
+
+
+#endif /* DEADBAND_H_ */
+/********************************** end of deadband.h **********************************/
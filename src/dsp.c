@@ -0,0 +1,268 @@
+/************************************************************************************//**
+* \file     dsp.c
+* \brief    This module implements fixed-point signal processing kernels.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "dsp.h"                     /* Fixed-point signal processing kernels          */
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief First quarter of sine period, sin(2*pi*k/DSP_SINE_POINTS) in q15 format. */
+static const int16_t sineTable[DSP_SINE_POINTS/4 + 1] =
+{
+      0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,
+   2009,  2210,  2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,
+   4011,  4211,  4410,  4609,  4808,  5007,  5205,  5404,  5602,  5800,
+   5998,  6195,  6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,
+   7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,  9512,  9704,
+   9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+  11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463,
+  13646, 13828, 14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+  15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673, 16846, 17018,
+  17190, 17361, 17531, 17700, 17869, 18037, 18205, 18372, 18538, 18703,
+  18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001, 20160, 20318,
+  20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+  22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312,
+  23453, 23593, 23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680,
+  24812, 24943, 25073, 25202, 25330, 25457, 25583, 25708, 25833, 25956,
+  26078, 26199, 26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+  27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002, 28106, 28209,
+  28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+  29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038,
+  30118, 30196, 30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+  30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298, 31357, 31415,
+  31471, 31527, 31581, 31634, 31686, 31737, 31786, 31834, 31881, 31927,
+  31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251, 32286, 32319,
+  32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738,
+  32746, 32753, 32758, 32762, 32766, 32767, 32767
+};
+/** \brief CORDIC angles atan(2^-i) in units of 2^-32 of full turn. */
+static const int32_t cordicAngle[DSP_CORDIC_STEPS] =
+{
+  536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163,   1335087,    667544,   333772,   166886,    83443,    41722,   20861
+};
+
+
+/****************************************************************************************
+*                        T R I G O N O M E T R Y   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Table based sine.
+** \param     idx Phase index, one period equals DSP_SINE_POINTS.
+** \return    sin(2*pi*idx/DSP_SINE_POINTS) in q15 format.
+**
+****************************************************************************************/
+int16_t dspSin(uint16_t idx)
+{
+  /* Wrap phase to one period. */
+  idx &= (DSP_SINE_POINTS - 1);
+  
+  /* Mirror first quarter to the rest of the period. */
+  if(idx <= DSP_SINE_POINTS/4)         return  sineTable[idx];
+  else if(idx <= DSP_SINE_POINTS/2)    return  sineTable[DSP_SINE_POINTS/2 - idx];
+  else if(idx <= DSP_SINE_POINTS*3/4)  return -sineTable[idx - DSP_SINE_POINTS/2];
+  else                                 return -sineTable[DSP_SINE_POINTS - idx];
+} /*** end of dspSin ***/
+
+/************************************************************************************//**
+** \brief     Table based cosine.
+** \param     idx Phase index, one period equals DSP_SINE_POINTS.
+** \return    cos(2*pi*idx/DSP_SINE_POINTS) in q15 format.
+**
+****************************************************************************************/
+int16_t dspCos(uint16_t idx)
+{
+  return dspSin(idx + DSP_SINE_POINTS/4);
+} /*** end of dspCos ***/
+
+/************************************************************************************//**
+** \brief     Sine with linear interpolation between table values.
+** \param     phase Phase, one period equals 2^32.
+** \return    sin(2*pi*phase/2^32) in q15 format.
+**
+****************************************************************************************/
+int16_t dspSinInterp(uint32_t phase)
+{
+  /* Upper bits select table value, lower 16 bits of the rest are the fraction. */
+  uint16_t idx = (uint16_t)(phase >> 22);
+  int32_t frac = (int32_t)((phase >> 6) & 0xFFFF);
+  int32_t s0 = dspSin(idx);
+  int32_t s1 = dspSin(idx + 1);
+  
+  return (int16_t)(s0 + (((s1 - s0) * frac) >> 16));
+} /*** end of dspSinInterp ***/
+
+/************************************************************************************//**
+** \brief     CORDIC in vectoring mode, calculates magnitude and angle of a vector.
+** \param     x Real part, absolute value must be below 2^29.
+** \param     y Imaginary part, absolute value must be below 2^29.
+** \param     mag Pointer where magnitude is stored.
+** \param     angle Pointer where angle is stored, full turn equals 2^32.
+**
+****************************************************************************************/
+void dspCordic(int32_t x, int32_t y, uint32_t *mag, int32_t *angle)
+{
+  int32_t tmp;
+  uint32_t ang = 0;
+  
+  /* Rotate to right half plane first. */
+  if(x < 0)
+  {
+    x = -x;
+    y = -y;
+    ang = 0x80000000UL;
+  }
+  /* Rotate vector to x axis, sum of rotations is the angle. */
+  for(uint8_t i = 0; i < DSP_CORDIC_STEPS; i++)
+  {
+    tmp = x;
+    if(y > 0)
+    {
+      x += y >> i;
+      y -= tmp >> i;
+      ang += (uint32_t)cordicAngle[i];
+    }
+    else
+    {
+      x -= y >> i;
+      y += tmp >> i;
+      ang -= (uint32_t)cordicAngle[i];
+    }
+  }
+  /* Remove CORDIC gain. */
+  *mag = (uint32_t)(((int64_t)x * DSP_CORDIC_GAIN_INV) >> 15);
+  *angle = (int32_t)ang;
+} /*** end of dspCordic ***/
+
+
+/****************************************************************************************
+*                          T R A N S F O R M   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     In-place radix-2 decimation in time FFT. Every stage is scaled by 1/2 so
+**            the result is scaled by 1/points and can not overflow.
+** \param     buf Interleaved complex q15 buffer (re, im), 2*points values long.
+** \param     points Number of complex points, power of two up to DSP_FFT_MAX_POINTS.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool dspFftQ15(int16_t *buf, uint16_t points)
+{
+  uint16_t i, j, k, bit, len, half, step;
+  int16_t tmp;
+  int32_t wr, wi, tr, ti;
+  
+  /* Only power of two lengths which are covered by the sine table. */
+  if((points < 2) || (points > DSP_FFT_MAX_POINTS) || (points & (points - 1)))
+  {
+    return false;
+  }
+  
+  /* Bit reversal permutation. */
+  for(i = 1, j = 0; i < points; i++)
+  {
+    for(bit = points >> 1; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j ^= bit;
+    if(i < j)
+    {
+      tmp = buf[2*i];     buf[2*i]     = buf[2*j];     buf[2*j]     = tmp;
+      tmp = buf[2*i + 1]; buf[2*i + 1] = buf[2*j + 1]; buf[2*j + 1] = tmp;
+    }
+  }
+  
+  /* Butterfly stages. */
+  for(len = 2; len <= points; len <<= 1)
+  {
+    half = len >> 1;
+    step = DSP_SINE_POINTS / len;
+    for(k = 0; k < half; k++)
+    {
+      /* Twiddle factor e^(-j*2*pi*k/len). */
+      wr =  dspCos(k * step);
+      wi = -dspSin(k * step);
+      for(i = k; i < points; i += len)
+      {
+        j = i + half;
+        tr = (wr * buf[2*j] - wi * buf[2*j + 1]) >> 15;
+        ti = (wr * buf[2*j + 1] + wi * buf[2*j]) >> 15;
+        buf[2*j]     = (int16_t)((buf[2*i]     - tr) >> 1);
+        buf[2*j + 1] = (int16_t)((buf[2*i + 1] - ti) >> 1);
+        buf[2*i]     = (int16_t)((buf[2*i]     + tr) >> 1);
+        buf[2*i + 1] = (int16_t)((buf[2*i + 1] + ti) >> 1);
+      }
+    }
+  }
+  
+  /* Return result. */
+  return true;
+} /*** end of dspFftQ15 ***/
+
+/************************************************************************************//**
+** \brief     Applies Hann window to real q15 values.
+** \param     buf Buffer with values to window.
+** \param     points Window length, power of two up to DSP_SINE_POINTS.
+** \param     stride Distance between two consecutive values in buffer.
+**
+****************************************************************************************/
+void dspHannQ15(int16_t *buf, uint16_t points, uint16_t stride)
+{
+  uint16_t step = DSP_SINE_POINTS / points;
+  int32_t w;
+  
+  for(uint16_t i = 0; i < points; i++)
+  {
+    /* w = 0.5 - 0.5*cos(2*pi*i/points) */
+    w = (32767 - dspCos(i * step)) >> 1;
+    buf[i * stride] = (int16_t)((w * buf[i * stride]) >> 15);
+  }
+} /*** end of dspHannQ15 ***/
+
+
+/****************************************************************************************
+*                               M A T H   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Integer square root.
+** \param     val Value.
+** \return    floor(sqrt(val)).
+**
+****************************************************************************************/
+uint16_t dspSqrt32(uint32_t val)
+{
+  uint32_t res = 0;
+  uint32_t bit = 1UL << 30;
+  
+  /* Start with the highest power of four not greater than value. */
+  while(bit > val)
+  {
+    bit >>= 2;
+  }
+  while(bit)
+  {
+    if(val >= res + bit)
+    {
+      val -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else
+    {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)res;
+} /*** end of dspSqrt32 ***/
+
+
+/************************************* end of dsp.c ************************************/
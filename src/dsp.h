@@ -0,0 +1,48 @@
+/************************************************************************************//**
+* \file     dsp.h
+* \brief    This module implements fixed-point signal processing kernels.
+****************************************************************************************/
+#ifndef DSP_H_
+#define DSP_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of points of one full sine period in the sine table */
+#define DSP_SINE_POINTS     1024
+/** \brief Minimum supported FFT length */
+#define DSP_FFT_MIN_POINTS  256
+/** \brief Maximum supported FFT length */
+#define DSP_FFT_MAX_POINTS  DSP_SINE_POINTS
+/** \brief Number of CORDIC iterations */
+#define DSP_CORDIC_STEPS    16
+/** \brief Inverse of CORDIC gain in q15 format */
+#define DSP_CORDIC_GAIN_INV 19898
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+/* Table based trigonometry, q15 results. */
+int16_t dspSin(uint16_t idx);
+int16_t dspCos(uint16_t idx);
+int16_t dspSinInterp(uint32_t phase);
+void dspCordic(int32_t x, int32_t y, uint32_t *mag, int32_t *angle);
+
+/* Transforms. */
+bool dspFftQ15(int16_t *buf, uint16_t points);
+void dspHannQ15(int16_t *buf, uint16_t points, uint16_t stride);
+
+/* Helpers. */
+uint16_t dspSqrt32(uint32_t val);
+
+
+#endif /* DSP_H_ */
+/************************************* end of dsp.h ************************************/
@@ -0,0 +1,218 @@
+/************************************************************************************//**
+* \file     event.c
+* \brief    This module implements event queues handled in PendSV. Interrupts only post
+*           events, their processing is done by handlers in PendSV at the lowest
+*           priority. Every queue has one producer, so it is written without disabling
+*           interrupts.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "event.h"                   /* Event queues                                   */
+#include "core.h"                    /* Core functionality for acquisition             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief BASEPRI value which masks USB interrupt and PendSV */
+#define EVENT_LOCK_BASEPRI  (USB_IRQ_PRIORITY << (8 - __NVIC_PRIO_BITS))
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Single producer queue, tail is written by producer, head by PendSV */
+typedef struct
+{
+  uint8_t type[EVENT_QUEUE_SIZE];    /* Event types                                    */
+  uint32_t par[EVENT_QUEUE_SIZE];    /* Event parameters                               */
+  volatile uint32_t tail;            /* Total number of events posted                  */
+  volatile uint32_t head;            /* Total number of events taken by PendSV         */
+}event_queue_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void eventRun(void);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Event queues, one for every producer. */
+static event_queue_t eventQueues[EVENT_QUEUES];
+/** \brief Handlers of event types, events without handler are discarded. */
+static event_handler_t eventHandlers[EVENT_TYPES];
+/** \brief Indicates event posted once was not taken by PendSV yet. */
+static volatile bool eventPosted[EVENT_TYPES];
+
+
+/****************************************************************************************
+*                                 E V E N T   Q U E U E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Sets PendSV priority and initializes sleep manager. Timers, ADC and PDC
+**            need clocks, so core never sleeps deeper than WFI. Called before USB is
+**            started.
+**
+****************************************************************************************/
+void eventInit(void)
+{
+  NVIC_SetPriority(PendSV_IRQn, EVENT_IRQ_PRIORITY);
+  sleepmgr_init();
+  sleepmgr_lock_mode(SLEEPMGR_SLEEP_WFI);
+} /*** end of eventInit ***/
+
+/************************************************************************************//**
+** \brief     Sets handler of event type.
+** \param     type Event type.
+** \param     handler Called in PendSV for every event of the type, may be NULL.
+**
+****************************************************************************************/
+void eventSetHandler(uint8_t type, event_handler_t handler)
+{
+  if(type < EVENT_TYPES)
+  {
+    eventHandlers[type] = handler;
+  }
+} /*** end of eventSetHandler ***/
+
+/************************************************************************************//**
+** \brief     Posts event to queue. Must only be called by producer of the queue.
+** \param     queue Event queue.
+** \param     type Event type.
+** \param     par Parameter passed to handler.
+** \return    True if successful, false if queue is full.
+**
+****************************************************************************************/
+bool eventPost(uint8_t queue, uint8_t type, uint32_t par)
+{
+  event_queue_t *q = &eventQueues[queue];
+  uint32_t tail = q->tail;
+
+  if(tail - q->head >= EVENT_QUEUE_SIZE)
+  {
+    return false;
+  }
+  q->type[tail % EVENT_QUEUE_SIZE] = type;
+  q->par[tail % EVENT_QUEUE_SIZE] = par;
+  /* Event is stored before PendSV may see it. */
+  __DMB();
+  q->tail = tail + 1;
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  return true;
+} /*** end of eventPost ***/
+
+/************************************************************************************//**
+** \brief     Posts event unless the same type is already waiting. Handler sees state
+**            after the last post, so repeated posts are merged into one event.
+** \param     queue Event queue.
+** \param     type Event type, always posted to the same queue.
+** \return    True if event is waiting, false if queue is full.
+**
+****************************************************************************************/
+bool eventPostOnce(uint8_t queue, uint8_t type)
+{
+  if(eventPosted[type])
+  {
+    return true;
+  }
+  eventPosted[type] = true;
+  if(!eventPost(queue, type, 0))
+  {
+    eventPosted[type] = false;
+    return false;
+  }
+  return true;
+} /*** end of eventPostOnce ***/
+
+/************************************************************************************//**
+** \brief     Masks USB interrupt and PendSV, interrupts which re-arm PDC stay enabled.
+**            Protects data shared by event handlers and USB stack.
+** \return    Previous mask, given to eventUnlock.
+**
+****************************************************************************************/
+uint32_t eventLock(void)
+{
+  uint32_t basepri = __get_BASEPRI();
+
+  /* Mask which is already stricter is kept. */
+  if(!basepri || (basepri > EVENT_LOCK_BASEPRI))
+  {
+    __set_BASEPRI(EVENT_LOCK_BASEPRI);
+  }
+  return basepri;
+} /*** end of eventLock ***/
+
+/************************************************************************************//**
+** \brief     Restores mask which was set before eventLock.
+** \param     basepri Value returned by eventLock.
+**
+****************************************************************************************/
+void eventUnlock(uint32_t basepri)
+{
+  __set_BASEPRI(basepri);
+} /*** end of eventUnlock ***/
+
+/************************************************************************************//**
+** \brief     Handles waiting events one at a time, the first queue has priority.
+**
+****************************************************************************************/
+void eventRun(void)
+{
+  event_queue_t *q;
+  uint32_t head, par;
+  uint8_t type, queue;
+
+  while(1)
+  {
+    for(queue = 0; queue < EVENT_QUEUES; queue++)
+    {
+      if(eventQueues[queue].tail != eventQueues[queue].head)
+      {
+        break;
+      }
+    }
+    if(queue == EVENT_QUEUES)
+    {
+      return;
+    }
+    q = &eventQueues[queue];
+    head = q->head;
+    type = q->type[head % EVENT_QUEUE_SIZE];
+    par = q->par[head % EVENT_QUEUE_SIZE];
+    /* Entry is read before producer may reuse it. */
+    __DMB();
+    q->head = head + 1;
+    if(type < EVENT_TYPES)
+    {
+      /* Posts from now on are seen by this handler or cause a new event. */
+      eventPosted[type] = false;
+      if(eventHandlers[type] != NULL)
+      {
+        eventHandlers[type](par);
+      }
+    }
+  }
+} /*** end of eventRun ***/
+
+
+/****************************************************************************************
+*                          I N T E R R U P T   H A N D L E R S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     PendSV exception handler, set pending by every posted event. Interrupts
+**            preempt it, events they post are handled before it returns.
+**
+****************************************************************************************/
+void PendSV_Handler(void)
+{
+  eventRun();
+} /*** end of PendSV_Handler ***/
+
+
+/************************************ end of event.c ***********************************/
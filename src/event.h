@@ -0,0 +1,61 @@
+/************************************************************************************//**
+* \file     event.h
+* \brief    This module implements event queues handled in PendSV.
+****************************************************************************************/
+#ifndef EVENT_H_
+#define EVENT_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of events in one queue, power of 2 */
+#define EVENT_QUEUE_SIZE    8
+
+/* Event queues, every queue has one producer and is handled in this order */
+/** \brief Posted by ADC interrupt */
+#define EVENT_QUEUE_ADC     0
+/** \brief Posted by USB interrupt */
+#define EVENT_QUEUE_USB     1
+/** \brief Number of event queues */
+#define EVENT_QUEUES        2
+
+/* Event types */
+/** \brief ADC block completed, parameter is block index */
+#define EVENT_ADC_BLOCK     0
+/** \brief Command bytes received on control port */
+#define EVENT_USB_RX        1
+/** \brief Interface has room for more data */
+#define EVENT_USB_TX        2
+/** \brief Samples of block being filled waited long enough to be sent */
+#define EVENT_FLUSH         3
+/** \brief Number of event types */
+#define EVENT_TYPES         4
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Handles event in PendSV, parameter is the one it was posted with */
+typedef void (*event_handler_t)(uint32_t par);
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void eventInit(void);
+void eventSetHandler(uint8_t type, event_handler_t handler);
+bool eventPost(uint8_t queue, uint8_t type, uint32_t par);
+bool eventPostOnce(uint8_t queue, uint8_t type);
+uint32_t eventLock(void);
+void eventUnlock(uint32_t basepri);
+
+
+#endif /* EVENT_H_ */
+/************************************ end of event.h ***********************************/
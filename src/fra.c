@@ -0,0 +1,383 @@
+/************************************************************************************//**
+* \file     fra.c
+* \brief    This module implements frequency response analyser of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include <math.h>                    /* Sweep frequency step                           */
+#include <string.h>                  /* Result packing                                 */
+#include "fra.h"                     /* Frequency response analyser                    */
+#include "status.h"                  /* Health and throughput counters                 */
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void fraStartPoint(void);
+void fraSend(void);
+void fraRecordSent(uint8_t *buf, uint32_t len);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Structure with all the settings. */
+static daq_settings_t * fraSettings;
+/** \brief Indicates sweep is running. */
+static volatile bool fraActive = false;
+/** \brief Stimulus frequency of current point in Hz. */
+static float fraFreq;
+/** \brief Frequency ratio between two consecutive points. */
+static float fraRatio;
+/** \brief Number of points in sweep. */
+static uint16_t fraPoints;
+/** \brief Index of current point. */
+static uint16_t fraPoint;
+/** \brief Number of stimulus periods accumulated at every point. */
+static uint16_t fraPeriods;
+/** \brief Stimulus amplitude in DAC codes. */
+static uint16_t fraAmplitude;
+/** \brief Number of LUT values in one stimulus period. */
+static uint16_t fraLutLength;
+/** \brief Sum of squared stimulus over one period. */
+static uint32_t fraEnergy;
+/** \brief Number of triggers left to settle. */
+static uint32_t fraSkip;
+/** \brief Number of triggers left to accumulate. */
+static uint32_t fraLeft;
+/** \brief LUT index of current trigger. */
+static uint16_t fraIdx;
+/** \brief Trigger within current LUT index. */
+static uint8_t fraSub;
+/** \brief Position of next sample in channel sequence. */
+static uint8_t fraPos;
+/** \brief In-phase and quadrature reference of current trigger. */
+static int32_t fraRefI, fraRefQ;
+/** \brief In-phase and quadrature accumulators of each channel. */
+static int64_t fraI[4], fraQ[4];
+/** \brief LUT of user, restored when sweep ends. */
+static uint16_t fraSavedLut[DACC_BUFFER_SIZE*2];
+/** \brief LUT length, DAC period and repeats of user. */
+static uint16_t fraSavedLutLength, fraSavedDacPeriod, fraSavedRepeats;
+/** \brief DAC transfer mode of user. */
+static uint8_t fraSavedTransferMode;
+/** \brief Point results, each stays untouched until transmit arbiter sent it. */
+static uint8_t fraRecords[FRA_RECORDS][FRA_RECORD_SIZE];
+/** \brief Indicates point result is queued. */
+static volatile bool fraRecordBusy[FRA_RECORDS];
+
+
+/****************************************************************************************
+*                             S W E E P   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Starts logarithmic frequency sweep. Acquisition and DAC are taken over
+**            until the sweep ends or is stopped. LUT, DAC period, repeats and transfer
+**            mode are saved and restored by fraStop.
+** \param     fStart First frequency in Hz.
+** \param     fStop Last frequency in Hz.
+** \param     points Number of frequency points.
+** \param     periods Number of stimulus periods accumulated at every point.
+** \param     amplitude Stimulus amplitude in DAC codes.
+** \param     settings Pointer to DAQ settings.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool fraStart(uint32_t fStart, uint32_t fStop, uint16_t points, uint16_t periods,
+              uint16_t amplitude, daq_settings_t *settings)
+{
+  /* Check if parameters are valid. */
+  if(!fStart || !fStop || (fStart > FRA_MAX_FREQ) || (fStop > FRA_MAX_FREQ) || !points ||
+     !periods || !amplitude || (amplitude > FRA_MAX_AMPLITUDE) || !coreGetChannelCount())
+  {
+    return false;
+  }
+
+  /* Stop anything that is running, previous sweep gives DAC setup back first. */
+  fraStop();
+  timerStop();
+  dacTimerStop();
+
+  fraSettings = settings;
+  fraSavedLutLength = settings->LutLength;
+  for(uint32_t i = 0; i < 2*(uint32_t)fraSavedLutLength; i++)
+  {
+    fraSavedLut[i] = settings->Lut[i];
+  }
+  fraSavedDacPeriod = settings->DacPeriod;
+  fraSavedRepeats = settings->NumOfRepeats;
+  fraSavedTransferMode = getDacTransferMode();
+  fraPoints = points;
+  fraPoint = 0;
+  fraPeriods = periods;
+  fraAmplitude = amplitude;
+  fraFreq = (float)fStart;
+  fraRatio = 1.0f;
+  if(points > 1)
+  {
+    fraRatio = powf((float)fStop / (float)fStart, 1.0f / (float)(points - 1));
+  }
+
+  /* Both DAC channels output stimulus, ADC is triggered together with DAC. */
+  setDacTransferMode(1);
+  adcSetTrigger(true);
+  adcHandler(true);
+  fraActive = true;
+  fraStartPoint();
+
+  return true;
+} /*** end of fraStart ***/
+
+/************************************************************************************//**
+** \brief     Stops sweep and gives ADC trigger back to ADC timer. LUT and DAC setup of
+**            user are restored, DAC stays stopped.
+**
+****************************************************************************************/
+void fraStop(void)
+{
+  if(fraActive)
+  {
+    fraActive = false;
+    dacTimerStop();
+    adcSetTrigger(false);
+    adcRestartPdc();
+
+    for(uint32_t i = 0; i < 2*(uint32_t)fraSavedLutLength; i++)
+    {
+      fraSettings->Lut[i] = fraSavedLut[i];
+    }
+    fraSettings->LutLength = fraSavedLutLength;
+    SetDacPdcLength();
+    fraSettings->DacPeriod = fraSavedDacPeriod;
+    setDacPeriod();
+    fraSettings->NumOfRepeats = fraSavedRepeats;
+    fraSettings->CurrentRepeats = 0;
+    setDacTransferMode(fraSavedTransferMode);
+    dacRestartPdc();
+  }
+} /*** end of fraStop ***/
+
+/************************************************************************************//**
+** \brief     Checks if sweep is running.
+** \return    True if sweep is running, false otherwise.
+**
+****************************************************************************************/
+bool fraIsActive(void)
+{
+  return fraActive;
+} /*** end of fraIsActive ***/
+
+/************************************************************************************//**
+** \brief     Prepares stimulus LUT and DAC period of current point and starts it.
+**
+****************************************************************************************/
+void fraStartPoint(void)
+{
+  uint32_t length, period;
+  int32_t val;
+
+  /* Use as many LUT values as shortest trigger period allows. */
+  length = (uint32_t)(1000000.0f / (fraFreq * FRA_MIN_PERIOD * FRA_TRIGGERS));
+  length &= ~3UL;
+  if(length > DACC_BUFFER_SIZE)   length = DACC_BUFFER_SIZE;
+  if(length < FRA_MIN_LUT_LENGTH) length = FRA_MIN_LUT_LENGTH;
+  period = (uint32_t)(1000000.0f / (fraFreq * length * FRA_TRIGGERS) + 0.5f);
+  if(period > 0xFFFF)             period = 0xFFFF;
+  if(period < FRA_MIN_PERIOD)     period = FRA_MIN_PERIOD;
+  fraLutLength = (uint16_t)length;
+
+  /* One sine period for both channels, 12th bit selects channel 2. */
+  fraEnergy = 0;
+  for(uint32_t i = 0; i < length; i++)
+  {
+    val = ((int32_t)dspSinInterp((uint32_t)(((uint64_t)i << 32) / length)) *
+           fraAmplitude) >> 15;
+    fraSettings->Lut[2*i]     = (uint16_t)(2048 + val);
+    fraSettings->Lut[2*i + 1] = (uint16_t)(2048 + val) | (1 << 12);
+    /* Every value is held for all its triggers. */
+    fraEnergy += (uint32_t)(val * val) * FRA_TRIGGERS;
+  }
+  fraSettings->LutLength = fraLutLength;
+  SetDacPdcLength();
+  fraSettings->DacPeriod = (uint16_t)period;
+  setDacPeriod();
+  fraSettings->NumOfRepeats = 0;
+  fraSettings->CurrentRepeats = 0;
+
+  /* Reset detector. */
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    fraI[ch] = 0;
+    fraQ[ch] = 0;
+  }
+  fraIdx = 0;
+  fraSub = 0;
+  fraPos = 0;
+  fraSkip = (uint32_t)fraLutLength * FRA_TRIGGERS * FRA_SETTLE_PERIODS;
+  fraLeft = (uint32_t)fraLutLength * FRA_TRIGGERS * fraPeriods;
+
+  /* First ADC sample and first LUT value belong to the same trigger. */
+  adcRestartPdc();
+  dacRestartPdc();
+  dacTimerStart();
+} /*** end of fraStartPoint ***/
+
+/************************************************************************************//**
+** \brief     Accumulates completed ADC block. ADC is triggered together with DAC, so
+**            every trigger belongs to a known LUT index. Samples are multiplied by the
+**            stimulus (in-phase) and by the stimulus shifted for a quarter of period
+**            (quadrature). When current point is complete its result is sent and next
+**            point is started.
+** \param     block Pointer to completed ADC block.
+**
+****************************************************************************************/
+void fraProcess(uint16_t *block)
+{
+  uint8_t chCount = coreGetChannelCount();
+  uint32_t size = *fraSettings->blockSize;
+  uint16_t quarter = fraLutLength / 4;
+  uint16_t idx;
+  /* 10-bit codes are scaled to 12 bits so gain does not depend on resolution. */
+  int32_t mid = fraSettings->ADClowRes ? 512 : 2048;
+  int32_t scale = fraSettings->ADClowRes ? 4 : 1;
+  int32_t x;
+
+  for(uint32_t i = 0; (i < size) && fraLeft; i++)
+  {
+    /* New trigger, reference is stimulus itself and stimulus shifted for 90 deg. */
+    if(fraPos == 0)
+    {
+      idx = fraIdx + quarter;
+      if(idx >= fraLutLength) idx -= fraLutLength;
+      fraRefI = (int32_t)(fraSettings->Lut[2*fraIdx] & 0x0FFF) - 2048;
+      fraRefQ = (int32_t)(fraSettings->Lut[2*idx] & 0x0FFF) - 2048;
+    }
+    if(!fraSkip)
+    {
+      x = ((int32_t)(block[i] & 0x0FFF) - mid) * scale;
+      fraI[fraPos] += x * fraRefI;
+      fraQ[fraPos] += x * fraRefQ;
+    }
+    if(++fraPos >= chCount)
+    {
+      fraPos = 0;
+      if(++fraSub >= FRA_TRIGGERS)
+      {
+        fraSub = 0;
+        if(++fraIdx >= fraLutLength) fraIdx = 0;
+      }
+      if(fraSkip) fraSkip--;
+      else        fraLeft--;
+    }
+  }
+
+  /* Point is complete? */
+  if(!fraLeft)
+  {
+    dacTimerStop();
+    fraSend();
+    if(++fraPoint < fraPoints)
+    {
+      fraFreq *= fraRatio;
+      fraStartPoint();
+    }
+    else
+    {
+      fraStop();
+    }
+  }
+} /*** end of fraProcess ***/
+
+/************************************************************************************//**
+** \brief     Sends result of current point. Two sync bytes (point index), frequency in
+**            mHz (uint32) and for every enabled channel gain in q16 format (uint32)
+**            and phase in 0.01 deg (int16), all little endian. Result which does not
+**            fit to transmit queue is dropped and counted as dropped frame.
+**
+****************************************************************************************/
+void fraSend(void)
+{
+  uint8_t chCount = coreGetChannelCount();
+  uint8_t *record = NULL;
+  uint8_t slot;
+  uint8_t len = 0;
+  uint32_t freq, mag, gain;
+  int32_t angle;
+  int16_t phase;
+  int64_t i, q;
+  uint8_t shift;
+
+  /* Queued results are not overwritten, point is dropped when all are waiting. */
+  for(slot = 0; slot < FRA_RECORDS; slot++)
+  {
+    if(!fraRecordBusy[slot])
+    {
+      record = fraRecords[slot];
+      break;
+    }
+  }
+  if(!record)
+  {
+    statusCount(STATUS_FRAMES_DROPPED);
+    return;
+  }
+
+  /* Sync bytes hold index of the point. */
+  record[len++] = ( fraPoint       & 0b1111111) | 0b10000000;
+  record[len++] = ((fraPoint >> 7) & 0b1111111) | 0b10000000;
+  /* Actual frequency, trigger period is in microseconds. */
+  freq = 1000000000UL / ((uint32_t)fraLutLength * FRA_TRIGGERS * fraSettings->DacPeriod);
+  memcpy(&record[len], &freq, 4);
+  len += 4;
+
+  for(uint8_t ch = 0; ch < chCount; ch++)
+  {
+    /* Scale accumulators to CORDIC range. */
+    i = fraI[ch];
+    q = fraQ[ch];
+    shift = 0;
+    while((i >= FRA_CORDIC_LIMIT) || (i <= -FRA_CORDIC_LIMIT) ||
+          (q >= FRA_CORDIC_LIMIT) || (q <= -FRA_CORDIC_LIMIT))
+    {
+      i >>= 1;
+      q >>= 1;
+      shift++;
+    }
+    dspCordic((int32_t)i, (int32_t)q, &mag, &angle);
+    /* Gain is response amplitude over stimulus amplitude. */
+    gain = 0;
+    if(fraEnergy)
+    {
+      gain = (uint32_t)((((uint64_t)mag << shift) << 16) /
+                        ((uint64_t)fraEnergy * fraPeriods));
+    }
+    phase = (int16_t)(((int64_t)angle * 36000) >> 32);
+    memcpy(&record[len], &gain, 4);
+    len += 4;
+    memcpy(&record[len], &phase, 2);
+    len += 2;
+  }
+  /* Record is released by the arbiter, failed frame is already counted by it. */
+  fraRecordBusy[slot] = true;
+  if(!txFrame(record, len, NULL, 0, fraRecordSent))
+  {
+    fraRecordBusy[slot] = false;
+  }
+} /*** end of fraSend ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when point result was sent or dropped.
+** \param     buf Start of the frame, point result.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void fraRecordSent(uint8_t *buf, uint32_t len)
+{
+  fraRecordBusy[(buf - fraRecords[0]) / FRA_RECORD_SIZE] = false;
+} /*** end of fraRecordSent ***/
+
+
+/************************************* end of fra.c ************************************/
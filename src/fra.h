@@ -0,0 +1,53 @@
+/************************************************************************************//**
+* \file     fra.h
+* \brief    This module implements frequency response analyser of the DAQ.
+****************************************************************************************/
+#ifndef FRA_H_
+#define FRA_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "dsp.h"                     /* Fixed-point signal processing kernels          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Shortest DAC and ADC trigger period during sweep in microseconds */
+#define FRA_MIN_PERIOD      10
+/** \brief Shortest LUT used for one stimulus period, must be multiple of 4 */
+#define FRA_MIN_LUT_LENGTH  16
+/** \brief DAC converts one half word per trigger, both channels need two triggers */
+#define FRA_TRIGGERS        2
+/** \brief Highest stimulus frequency in Hz */
+#define FRA_MAX_FREQ        (1000000 / (FRA_MIN_PERIOD * FRA_MIN_LUT_LENGTH * \
+                                        FRA_TRIGGERS))
+/** \brief Number of stimulus periods skipped before detection starts */
+#define FRA_SETTLE_PERIODS  1
+/** \brief Maximum stimulus amplitude in DAC codes */
+#define FRA_MAX_AMPLITUDE   2047
+/** \brief Accumulators are scaled below this value before CORDIC */
+#define FRA_CORDIC_LIMIT    (1L << 29)
+/** \brief Bytes of point result, sync bytes, frequency and 4 channels */
+#define FRA_RECORD_SIZE     (2 + 4 + 4*6)
+/** \brief Number of point results which may wait in transmit queue */
+#define FRA_RECORDS         4
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+bool fraStart(uint32_t fStart, uint32_t fStop, uint16_t points, uint16_t periods,
+              uint16_t amplitude, daq_settings_t *settings);
+void fraStop(void);
+bool fraIsActive(void);
+void fraProcess(uint16_t *block);
+
+
+#endif /* FRA_H_ */
+/************************************* end of fra.h ************************************/
@@ -0,0 +1,211 @@
+/************************************************************************************//**
+* \file     histogram.c
+* \brief    This module implements histogram mode of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "histogram.h"               /* Histogram mode                                 */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of samples of every ADC code, channel after channel, in workspace. */
+#define HISTOGRAM_BUFF      ((uint16_t *)coreGetWorkspace())
+
+#if (HISTOGRAM_MAX_BINS * 2) > CORE_WORKSPACE_SIZE
+#error "Histogram bins do not fit to core workspace"
+#endif
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void histogramPrepare(uint16_t bins, uint8_t chCount);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Bins per channel of accumulated histogram. */
+static uint16_t histogramBinCount = 0;
+/** \brief Number of channels of accumulated histogram. */
+static uint8_t histogramChCount = 0;
+/** \brief Number of blocks accumulated since last send. */
+static uint16_t histogramBlocks = 0;
+/** \brief Indicates some bin is close to overflow. */
+static bool histogramFull = false;
+/** \brief Number of bytes of histogram waiting to be sent. */
+static uint16_t histogramLen = 0;
+/** \brief Indicates histogram is waiting to be sent. */
+static volatile bool histogramReady = false;
+/** \brief Sync bytes marking start of histogram, 7 bits each are bins per channel. */
+static uint8_t histogramSync[2];
+
+
+/****************************************************************************************
+*                         H I S T O G R A M   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Clears all bins. Must be called when histogram settings change.
+**
+****************************************************************************************/
+void histogramReset(void)
+{
+  uint16_t *histogramBins = HISTOGRAM_BUFF;
+
+  for(uint16_t i = 0; i < HISTOGRAM_MAX_BINS; i++)
+  {
+    histogramBins[i] = 0;
+  }
+  histogramBlocks = 0;
+  histogramFull = false;
+  histogramReady = false;
+} /*** end of histogramReset ***/
+
+/************************************************************************************//**
+** \brief     Obtains number of bins per channel for current ADC resolution.
+** \param     settings Pointer to DAQ settings.
+** \return    Bins per channel, 0 if histogram of enabled channels does not fit.
+**
+****************************************************************************************/
+uint16_t histogramGetBins(daq_settings_t *settings)
+{
+  uint16_t bins = settings->ADClowRes ? HISTOGRAM_BINS_LOWRES : HISTOGRAM_BINS;
+  uint8_t chCount = coreGetChannelCount();
+
+  if(!chCount || ((uint32_t)chCount * bins > HISTOGRAM_MAX_BINS))
+  {
+    return 0;
+  }
+  return bins;
+} /*** end of histogramGetBins ***/
+
+/************************************************************************************//**
+** \brief     Adds samples of completed block to the bins of their channels. Histogram
+**            is prepared for sending after set number of blocks or when some bin is
+**            close to overflow.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+** \return    True if histogram is ready, false otherwise.
+**
+****************************************************************************************/
+bool histogramProcess(uint16_t *block, daq_settings_t *settings)
+{
+  uint16_t *histogramBins = HISTOGRAM_BUFF;
+  uint8_t chCount = coreGetChannelCount();
+  uint16_t bins = histogramGetBins(settings);
+  uint32_t size = *settings->blockSize;
+  uint16_t *bin;
+  uint8_t ch = 0;
+
+  /* Previous histogram not sent yet or it does not fit, skip this block. */
+  if(histogramReady || !bins)
+  {
+    return false;
+  }
+  /* Resolution or channels changed, old counts do not belong to new bins. */
+  if((bins != histogramBinCount) || (chCount != histogramChCount))
+  {
+    histogramReset();
+    histogramBinCount = bins;
+    histogramChCount = chCount;
+  }
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    bin = &histogramBins[ch*bins + (block[i] & (bins - 1))];
+    if(++(*bin) >= HISTOGRAM_COUNT_LIMIT)
+    {
+      histogramFull = true;
+    }
+    if(++ch >= chCount)
+    {
+      ch = 0;
+    }
+  }
+  histogramBlocks++;
+
+  /* Send when period elapsed, or before counts overflow. */
+  if(histogramFull || (settings->histogramPeriod &&
+                       (histogramBlocks >= settings->histogramPeriod)))
+  {
+    histogramPrepare(bins, chCount);
+    return true;
+  }
+  return false;
+} /*** end of histogramProcess ***/
+
+/************************************************************************************//**
+** \brief     Marks accumulated histogram for sending and creates its sync bytes.
+** \param     bins Bins per channel.
+** \param     chCount Number of channels.
+**
+****************************************************************************************/
+void histogramPrepare(uint16_t bins, uint8_t chCount)
+{
+  histogramLen = bins * chCount * 2;
+  histogramSync[0] = ( bins       & 0b1111111) | 0b10000000;
+  histogramSync[1] = ((bins >> 7) & 0b1111111) | 0b10000000;
+  histogramReady = true;
+} /*** end of histogramPrepare ***/
+
+/************************************************************************************//**
+** \brief     Prepares histogram for sending on user request.
+** \return    Pointer to two sync bytes, NULL if there is no histogram.
+**
+****************************************************************************************/
+uint8_t * histogramRequest(void)
+{
+  if(!histogramBinCount)
+  {
+    return NULL;
+  }
+  /* Ready histogram is already queued. */
+  if(!histogramReady)
+  {
+    histogramPrepare(histogramBinCount, histogramChCount);
+    histogramSend();
+  }
+  return histogramSync;
+} /*** end of histogramRequest ***/
+
+/************************************************************************************//**
+** \brief     Checks if histogram is waiting to be sent.
+** \return    True if histogram is ready, false otherwise.
+**
+****************************************************************************************/
+bool histogramIsReady(void)
+{
+  return histogramReady;
+} /*** end of histogramIsReady ***/
+
+/************************************************************************************//**
+** \brief     Queues ready histogram after its sync bytes. A new one is started once it
+**            is sent.
+**
+****************************************************************************************/
+void histogramSend(void)
+{
+  if(!txFrame(histogramSync, 2, (uint8_t *)HISTOGRAM_BUFF, histogramLen, histogramSent))
+  {
+    histogramReset();
+  }
+} /*** end of histogramSend ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when histogram was sent.
+** \param     buf Start of the frame, sync bytes.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void histogramSent(uint8_t *buf, uint32_t len)
+{
+  histogramReset();
+} /*** end of histogramSent ***/
+
+
+/********************************** end of histogram.c *********************************/
@@ -0,0 +1,43 @@
+/************************************************************************************//**
+* \file     histogram.h
+* \brief    This module implements histogram mode of the DAQ.
+****************************************************************************************/
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "tx.h"                      /* Transmit arbiter                               */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of bins of one channel, one bin per ADC code */
+#define HISTOGRAM_BINS          4096
+/** \brief Number of bins of one channel in low resolution */
+#define HISTOGRAM_BINS_LOWRES   1024
+/** \brief Maximum number of bins of all channels together */
+#define HISTOGRAM_MAX_BINS      4096
+/** \brief Histogram is sent before any bin could overflow in next block */
+#define HISTOGRAM_COUNT_LIMIT   (0xFFFF - ADC_BUFFER_SIZE * 4)
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void histogramReset(void);
+uint16_t histogramGetBins(daq_settings_t *settings);
+bool histogramProcess(uint16_t *block, daq_settings_t *settings);
+uint8_t * histogramRequest(void);
+bool histogramIsReady(void);
+void histogramSend(void);
+void histogramSent(uint8_t *buf, uint32_t len);
+
+
+#endif /* HISTOGRAM_H_ */
+/********************************** end of histogram.h *********************************/
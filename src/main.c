@@ -10,12 +10,24 @@
 #include "comInterface.h"            /* USB interface driver                           */
 #include "core.h"                    /* Core functionality for acquisition             */
 #include "parser.h"                  /* Protocol parser with command handlers          */
+#include "spectrum.h"                /* Spectrum mode                                  */
+#include "ascii.h"                   /* Text output                                    */
+#include "csv.h"                     /* CSV streaming mode                             */
+#include "pack.h"                    /* Packed sample encoding                         */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "vendor.h"                  /* Vendor bulk streaming interface                */
+#include "event.h"                   /* Event queues                                   */
+#include "profile.h"                 /* Cycle counter profiling                        */
+#include "status.h"                  /* Health and throughput counters                 */
+#include "trace.h"                   /* Event trace                                    */
+#include "memory.h"                  /* SRAM usage measurement                         */
 
 
 /***************************************************************************************
 * Function prototypes
 ****************************************************************************************/
 void usbRxcallback(void);            /* Current interface receive callback handler     */
+void usbRxHandler(uint32_t par);     /* Command event handler                          */
 
 
 /****************************************************************************************
@@ -23,6 +35,10 @@ void usbRxcallback(void);            /* Current interface receive callback handl
 ****************************************************************************************/
 /** \brief Comunication interface structure */
 COM_t * USB;
+/** \brief Comunication interface structure of acquired data as text */
+COM_t * USBtext;
+/** \brief Comunication interface structure of acquired binary data */
+COM_t * USBdata;
 /** \brief Structure with all the core specific settings */
 daq_settings_t master_settings;
 
@@ -34,18 +50,30 @@ daq_settings_t master_settings;
 ****************************************************************************************/
 int main(void)
 {
+  /* Stack is painted before it is used, so its high-water mark can be read. */
+  memoryInit();
   /* WatchDog timer is currently not implemented. */
   wdt_disable(WDT);
   /* Initialize system clock controller. */
   sysclk_init();
   /* Initialize hardware specific settings. */
   board_init();
+  /* Sleep manager is used by USB driver too. */
+  eventInit();
+  /* Cycle counter is enabled in Debug builds only. */
+  PROFILE_INIT();
+  TRACE_INIT();
   
   /* Initialize pointer to communicate interface, in this case USB. */
-  USB = getComInterface();
-  /* Initialize pointers to callback function. */
+  USB = getComInterface(COM_PORT_CONTROL);
+  USBtext = getComInterface(COM_PORT_TEXT);
+  USBdata = getComInterface(COM_PORT_DATA);
+  /* Initialize pointers to callback function, commands come from control port. */
   USB->rxCallback = usbRxcallback;
+  eventSetHandler(EVENT_USB_RX, usbRxHandler);
   USB->txEmptyCallback = coreGetTxEmptyCallBackPtr();
+  USBtext->txEmptyCallback = coreGetTxEmptyCallBackPtr();
+  USBdata->txEmptyCallback = coreGetTxEmptyCallBackPtr();
   /* Initialize communicate interface */
   USB->init(NULL);
   
@@ -82,8 +110,26 @@ int main(void)
   master_settings.NumOfRepeats = 0;
   master_settings.DacPeriod = 2000; //us -> Sawtooth freq = 1/(5000 *10^-6s * 1024) 
   
+  /* Spectrum mode presets. */
+  master_settings.fftPoints = DSP_FFT_MIN_POINTS;
+  master_settings.spectrumType = SPECTRUM_MAGNITUDE;
+  master_settings.spectrumAverages = 1;
+  master_settings.histogramPeriod = 0;
+  master_settings.calibration = 0;
+  master_settings.asciiUnit = ASCII_UNIT_MV;
+  master_settings.asciiSeparator = ASCII_SEPARATOR_SPACE;
+  master_settings.csvIndex = CSV_INDEX_OFF;
+  master_settings.encoding = PACK_OFF;
+  master_settings.deadband = 0;
+  master_settings.heartbeat = 0;
+  master_settings.latency = VENDOR_LATENCY;
+  vendorSetLatency(master_settings.latency);
+  master_settings.blockLatency = 0;
+  
   /* Set pointer to linked interface driver. */
   master_settings.com = USB;
+  master_settings.textCom = USBtext;
+  master_settings.dataCom = USBdata;
   
   /* Make settings acesable from core module. */
   coreConfigure(&master_settings);
@@ -91,9 +137,10 @@ int main(void)
   /* Start core module (timers, ADC, DAC, PDC). */
   coreStart();
   
+  /* Interrupts post events which are handled in PendSV, core sleeps in between. */
   while(1)
   {
-    // Do something...
+    sleepmgr_enter_sleep();
   }
   
   return TRUE;
@@ -102,27 +149,49 @@ int main(void)
 
 
 /************************************************************************************//**
-** \brief     Callback function for all the incoming data.
+** \brief     Callback function for all the incoming data, commands are parsed by event
+**            handler.
 **
 ****************************************************************************************/
 void usbRxcallback(void)
+{
+  PROFILE_START();
+  TRACE_EVENT(TRACE_USB_RX, 0);
+  eventPostOnce(EVENT_QUEUE_USB, EVENT_USB_RX);
+  PROFILE_STOP(PROFILE_RX_NOTIFY);
+} /*** end of usbRxcallback ***/
+
+/************************************************************************************//**
+** \brief     Parses and executes received commands.
+** \param     par Not used.
+**
+****************************************************************************************/
+void usbRxHandler(uint32_t par)
 {
   /* Create command packet */
   CMD_t incomingCMD;
-  /* Is anything in RX buffer to read? */
-  if(USB->available())
+  uint8_t cmd;
+  /* Is a complete command line received? Partial line waits for next event. */
+  while(parserGetLine(USB, &cmd))
   {
+    PROFILE_START();
     /*
      * Parse incoming command from USB, save result in incomingCMD struct.
      * If command is supported, function returns int > 0.
      */
-    if (parseCommand(USB->read(), &incomingCMD, USB))
+    if (parseCommand(cmd, &incomingCMD, USB))
     {
+      TRACE_EVENT(TRACE_COMMAND, incomingCMD.cmd);
       /* Executes function that was set in incomingCMD */
       if(!incomingCMD.funcPtr(incomingCMD.par, &master_settings, USB))
       {
         /* Unable to set command with parameters, inform user. */
         USB->len = sprintf((char*)USB->buf, "ERROR setting command\n\r");
+        statusCount(STATUS_COMMAND_ERRORS);
+      }
+      else
+      {
+        statusCount(STATUS_COMMANDS);
       }
     }
     /* Command not parsed properly */
@@ -130,11 +199,13 @@ void usbRxcallback(void)
     {
       /* Command syntax in probably wrong, inform user. */
       USB->len = sprintf((char*)USB->buf, "Command syntax ERROR\n\r");
+      statusCount(STATUS_PARSE_ERRORS);
     }
-    /* Print message */
-    USB->printBuf(USB->buf, USB->len);
+    /* Print message, it is never sent inside a data frame. */
+    txReply(USB->buf, USB->len);
+    PROFILE_STOP(PROFILE_COMMAND);
   }
-} /*** end of usbRxcallback ***/
+} /*** end of usbRxHandler ***/
 
 
 /************************************ end of main.c ************************************/
\ No newline at end of file
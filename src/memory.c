@@ -0,0 +1,109 @@
+/************************************************************************************//**
+* \file     memory.c
+* \brief    This module implements SRAM usage measurement of the DAQ. Stack is painted
+*           with a pattern at boot, the deepest word which lost the pattern gives stack
+*           high-water mark. Memory above stack which heap did not take is free for
+*           acquisition buffers. Static data of every module is reported on the host
+*           from the linker map (host/map_report.c).
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "memory.h"                  /* SRAM usage measurement                         */
+
+
+/****************************************************************************************
+* External data declarations
+****************************************************************************************/
+/* Symbols of linker script, stack is between .bss and heap. */
+extern uint32_t _srelocate;
+extern uint32_t _ebss;
+extern uint32_t _sstack;
+extern uint32_t _estack;
+extern int __ram_end__;
+/* Heap of syscalls.c. */
+extern caddr_t _sbrk(int incr);
+
+
+/****************************************************************************************
+*                                      M E M O R Y
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Paints unused part of stack. Must be called first in main, while stack
+**            holds only a few words.
+**
+****************************************************************************************/
+void memoryInit(void)
+{
+  uint32_t sp = __get_MSP();
+  uint32_t *end = (uint32_t *)sp;
+
+  for(uint32_t *word = &_sstack; word < end; word++)
+  {
+    *word = MEMORY_PAINT;
+  }
+} /*** end of memoryInit ***/
+
+/************************************************************************************//**
+** \brief     Gets size of stack reserved by linker script.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t memoryStackSize(void)
+{
+  return (uint32_t)&_estack - (uint32_t)&_sstack;
+} /*** end of memoryStackSize ***/
+
+/************************************************************************************//**
+** \brief     Gets stack high-water mark since boot. When it equals stack size, stack
+**            has overflowed to static data below it.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t memoryStackUsed(void)
+{
+  uint32_t *word = &_sstack;
+
+  while((word < &_estack) && (*word == MEMORY_PAINT))
+  {
+    word++;
+  }
+  return (uint32_t)&_estack - (uint32_t)word;
+} /*** end of memoryStackUsed ***/
+
+/************************************************************************************//**
+** \brief     Gets size of initialized and zeroed static data.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t memoryStatic(void)
+{
+  return (uint32_t)&_ebss - (uint32_t)&_srelocate;
+} /*** end of memoryStatic ***/
+
+/************************************************************************************//**
+** \brief     Gets start of the largest free region, it is between heap and end of SRAM.
+** \return    Address of the first free byte.
+**
+****************************************************************************************/
+uint32_t memoryFreeStart(void)
+{
+  caddr_t heap = _sbrk(0);
+
+  return (uint32_t)heap;
+} /*** end of memoryFreeStart ***/
+
+/************************************************************************************//**
+** \brief     Gets size of the largest free region.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t memoryFree(void)
+{
+  return (uint32_t)&__ram_end__ - memoryFreeStart();
+} /*** end of memoryFree ***/
+
+
+/*********************************** end of memory.c ***********************************/
@@ -0,0 +1,34 @@
+/************************************************************************************//**
+* \file     memory.h
+* \brief    This module implements SRAM usage measurement of the DAQ.
+****************************************************************************************/
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Pattern of stack words which were never used */
+#define MEMORY_PAINT        0xC5C5C5C5
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void memoryInit(void);
+uint32_t memoryStackSize(void);
+uint32_t memoryStackUsed(void);
+uint32_t memoryStatic(void);
+uint32_t memoryFree(void);
+uint32_t memoryFreeStart(void);
+
+
+#endif /* MEMORY_H_ */
+/*********************************** end of memory.h ***********************************/
@@ -0,0 +1,303 @@
+/************************************************************************************//**
+* \file     pack.c
+* \brief    This module implements packed sample encoding of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "pack.h"                    /* Packed sample encoding                         */
+#include "profile.h"                 /* Cycle counter profiling                        */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Frame header followed by packed samples in workspace. */
+#define PACK_FRAME          ((uint8_t *)coreGetWorkspace())
+
+#if (PACK_RICE_HEADER_SIZE + ADC_BUFFER_SIZE * 4 * 2) > CORE_WORKSPACE_SIZE
+#error "Packed frame does not fit to core workspace"
+#endif
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint16_t packSamples(uint16_t *block, uint32_t size, uint8_t bits, uint8_t *out);
+uint16_t packRice(uint16_t *block, daq_settings_t *settings, uint8_t *out,
+                  uint16_t limit, uint16_t *params);
+bool packRiceInTime(daq_settings_t *settings);
+void packWriteBits(uint32_t val, uint8_t count);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Number of packed bytes after frame header. */
+static uint16_t packLength = 0;
+/** \brief Size of frame header. */
+static uint8_t packHeaderSize = PACK_HEADER_SIZE;
+/** \brief Output of bit writer. */
+static uint8_t *packOut;
+/** \brief Bits not yet written to output. */
+static uint32_t packAcc;
+/** \brief Number of bits not yet written to output. */
+static uint8_t packAccBits;
+
+
+/****************************************************************************************
+*                              P A C K I N G   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Packs completed block to frame in workspace. Channel tags are dropped,
+**            channel order is described once in frame header:
+**            byte 0, 1 - sync bytes, same as for a block of 16-bit words,
+**            byte 2    - number of channels in bits 7:4, bits per sample in bits 3:0,
+**            byte 3    - DAQ channel minus 1 of every sample in a row, 2 bits each,
+**                        first channel in bits 1:0.
+**            With Rice encoding the header continues with:
+**            byte 4, 5 - Rice parameter of every channel in a row, 4 bits each, first
+**                        channel in bits 3:0, PACK_RICE_RAW if block is packed,
+**            byte 6, 7 - number of bytes after header, LSB first.
+**            Packed samples follow LSB first, two 12-bit samples in 3 bytes or four
+**            10-bit samples in 5 bytes. Last byte is padded with zeros.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+** \return    Pointer to frame header.
+**
+****************************************************************************************/
+uint8_t * packProcess(uint16_t *block, daq_settings_t *settings)
+{
+  uint8_t *frame = PACK_FRAME;
+  uint32_t size = *settings->blockSize;
+  uint8_t chCount = coreGetChannelCount();
+  uint8_t bits = settings->ADClowRes ? PACK_BITS_10 : PACK_BITS_12;
+  uint16_t params = PACK_RICE_RAW;
+  PROFILE_START();
+
+  frame[0] = settings->syncBytes[0];
+  frame[1] = settings->syncBytes[1];
+  frame[2] = (chCount << 4) | bits;
+  frame[3] = 0;
+  for(uint8_t ch = 0; ch < chCount; ch++)
+  {
+    frame[3] |= (settings->sequence[ch] - 1) << (2 * ch);
+  }
+
+  if(settings->encoding != PACK_RICE)
+  {
+    packHeaderSize = PACK_HEADER_SIZE;
+    packLength = packSamples(block, size, bits, &frame[PACK_HEADER_SIZE]);
+    PROFILE_STOP(PROFILE_PACK);
+    return frame;
+  }
+
+  /* Block which does not compress or takes too long is packed. */
+  packHeaderSize = PACK_RICE_HEADER_SIZE;
+  packLength = 0;
+  if(packRiceInTime(settings))
+  {
+    packLength = packRice(block, settings, &frame[PACK_RICE_HEADER_SIZE],
+                          (uint16_t)((size * bits + 7) / 8), &params);
+  }
+  if(!packLength)
+  {
+    params = PACK_RICE_RAW;
+    packLength = packSamples(block, size, bits, &frame[PACK_RICE_HEADER_SIZE]);
+  }
+  frame[4] = (uint8_t)params;
+  frame[5] = (uint8_t)(params >> 8);
+  frame[6] = (uint8_t)packLength;
+  frame[7] = (uint8_t)(packLength >> 8);
+
+  PROFILE_STOP(PROFILE_PACK);
+  return frame;
+} /*** end of packProcess ***/
+
+/************************************************************************************//**
+** \brief     Obtains size of the last frame, header and packed samples together.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint32_t packGetFrameSize(void)
+{
+  return packHeaderSize + packLength;
+} /*** end of packGetFrameSize ***/
+
+/************************************************************************************//**
+** \brief     Packs samples LSB first without channel tags.
+** \param     block Pointer to completed ADC block.
+** \param     size Number of samples.
+** \param     bits Bits per sample.
+** \param     out Output buffer.
+** \return    Number of bytes.
+**
+****************************************************************************************/
+uint16_t packSamples(uint16_t *block, uint32_t size, uint8_t bits, uint8_t *out)
+{
+  uint32_t mask = (1 << bits) - 1;
+  uint32_t acc = 0;
+  uint8_t accBits = 0;
+  uint16_t len = 0;
+
+  for(uint32_t i = 0; i < size; i++)
+  {
+    acc |= (block[i] & mask) << accBits;
+    accBits += bits;
+    while(accBits >= 8)
+    {
+      out[len++] = (uint8_t)acc;
+      acc >>= 8;
+      accBits -= 8;
+    }
+  }
+  if(accBits)
+  {
+    out[len++] = (uint8_t)acc;
+  }
+  return len;
+} /*** end of packSamples ***/
+
+/************************************************************************************//**
+** \brief     Codes block with per channel delta and Rice code. First sample of every
+**            channel is sent as it is. Every other sample is sent as zigzag mapped
+**            difference u to previous sample of its channel: u >> k ones, a zero and
+**            k low bits of u. If u >> k is PACK_RICE_ESCAPE or more, PACK_RICE_ESCAPE
+**            ones are followed by the sample. Samples are in block order.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+** \param     out Output buffer.
+** \param     limit Size of packed block, coding stops when it is reached.
+** \param     params Rice parameter k of every channel, 4 bits each.
+** \return    Number of bytes, 0 if block does not compress.
+**
+****************************************************************************************/
+uint16_t packRice(uint16_t *block, daq_settings_t *settings, uint8_t *out,
+                  uint16_t limit, uint16_t *params)
+{
+  uint32_t size = *settings->blockSize;
+  uint8_t chCount = coreGetChannelCount();
+  uint8_t bits = settings->ADClowRes ? PACK_BITS_10 : PACK_BITS_12;
+  uint32_t mask = (1 << bits) - 1;
+  uint32_t sum[4] = {0, 0, 0, 0};
+  uint8_t k[4] = {0, 0, 0, 0};
+  int32_t prev[4];
+  int32_t val, delta;
+  uint32_t u, q, count;
+  uint8_t ch;
+
+  if(size <= chCount)
+  {
+    return 0;
+  }
+
+  /* First pass, Rice parameter is about log2 of mean mapped difference. */
+  for(uint32_t i = 0; i < size; i++)
+  {
+    ch = i % chCount;
+    val = block[i] & mask;
+    if(i >= chCount)
+    {
+      delta = val - prev[ch];
+      sum[ch] += ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    }
+    prev[ch] = val;
+  }
+  *params = 0;
+  for(ch = 0; ch < chCount; ch++)
+  {
+    count = (size - ch + chCount - 1) / chCount - 1;
+    while((k[ch] < bits - 1) && ((count << (k[ch] + 1)) <= sum[ch]))
+    {
+      k[ch]++;
+    }
+    *params |= k[ch] << (4 * ch);
+  }
+
+  /* Second pass, stop as soon as block is longer than packed block. */
+  packOut = out;
+  packLength = 0;
+  packAcc = 0;
+  packAccBits = 0;
+  for(uint32_t i = 0; i < size; i++)
+  {
+    ch = i % chCount;
+    val = block[i] & mask;
+    if(i < chCount)
+    {
+      packWriteBits((uint32_t)val, bits);
+    }
+    else
+    {
+      delta = val - prev[ch];
+      u = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+      q = u >> k[ch];
+      if(q < PACK_RICE_ESCAPE)
+      {
+        packWriteBits((1 << q) - 1, (uint8_t)q + 1);
+        packWriteBits(u & ((1 << k[ch]) - 1), k[ch]);
+      }
+      else
+      {
+        packWriteBits((1 << PACK_RICE_ESCAPE) - 1, PACK_RICE_ESCAPE);
+        packWriteBits((uint32_t)val, bits);
+      }
+    }
+    prev[ch] = val;
+    if(packLength >= limit)
+    {
+      return 0;
+    }
+  }
+  if(packAccBits)
+  {
+    out[packLength++] = (uint8_t)packAcc;
+  }
+  return (packLength < limit) ? packLength : 0;
+} /*** end of packRice ***/
+
+/************************************************************************************//**
+** \brief     Checks if block can be coded in half of the time it takes to sample it,
+**            so coding in PendSV never holds acquisition back.
+** \param     settings Pointer to DAQ settings.
+** \return    True if there is enough time, false otherwise.
+**
+****************************************************************************************/
+bool packRiceInTime(daq_settings_t *settings)
+{
+  uint8_t chCount = coreGetChannelCount();
+  uint64_t blockTime, codeTime;
+
+  if(!chCount)
+  {
+    return false;
+  }
+  /* Both in CPU cycles. */
+  blockTime = (uint64_t)settings->acqusitionTime * (*settings->blockSize / chCount) *
+              (sysclk_get_cpu_hz() / 1000000);
+  codeTime = (uint64_t)*settings->blockSize * PACK_RICE_CYCLES;
+  return (codeTime * 2) <= blockTime;
+} /*** end of packRiceInTime ***/
+
+/************************************************************************************//**
+** \brief     Writes bits to output LSB first.
+** \param     val Bits.
+** \param     count Number of bits, 17 at most.
+**
+****************************************************************************************/
+void packWriteBits(uint32_t val, uint8_t count)
+{
+  packAcc |= val << packAccBits;
+  packAccBits += count;
+  while(packAccBits >= 8)
+  {
+    packOut[packLength++] = (uint8_t)packAcc;
+    packAcc >>= 8;
+    packAccBits -= 8;
+  }
+} /*** end of packWriteBits ***/
+
+
+/************************************ end of pack.c ************************************/
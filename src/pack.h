@@ -0,0 +1,51 @@
+/************************************************************************************//**
+* \file     pack.h
+* \brief    This module implements packed sample encoding of the DAQ.
+****************************************************************************************/
+#ifndef PACK_H_
+#define PACK_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Encoding command values */
+/** \brief Every sample is a 16-bit word with channel tag */
+#define PACK_OFF            0
+/** \brief Samples are packed to 12 or 10 bits after frame header */
+#define PACK_ON             1
+/** \brief Deltas are Rice coded, blocks which do not compress are packed */
+#define PACK_RICE           2
+
+/** \brief Frame header, sync bytes, channel count with sample bits and channel order */
+#define PACK_HEADER_SIZE    4
+/** \brief Frame header followed by Rice parameters and payload length */
+#define PACK_RICE_HEADER_SIZE 8
+/** \brief Rice parameters of a block which is packed instead */
+#define PACK_RICE_RAW       0xFFFF
+/** \brief Longest unary quotient, larger deltas are sent as escape and sample */
+#define PACK_RICE_ESCAPE    16
+/** \brief Estimated CPU cycles to code one sample, both passes together */
+#define PACK_RICE_CYCLES    120
+/** \brief Bits of packed sample with 12-bit resolution */
+#define PACK_BITS_12        12
+/** \brief Bits of packed sample with 10-bit resolution */
+#define PACK_BITS_10        10
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint8_t * packProcess(uint16_t *block, daq_settings_t *settings);
+uint32_t packGetFrameSize(void);
+
+
+#endif /* PACK_H_ */
+/************************************ end of pack.h ************************************/
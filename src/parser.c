@@ -14,10 +14,15 @@
 * Function prototypes
 ****************************************************************************************/
 /* Parser functions */
+bool parRead(uint8_t *newChar);
+bool parEndLine(uint8_t *CMD);
 bool getPar(uint8_t parCount, uint16_t timeout, int32_t *parPtr, COM_t *comInterface);
+bool getOptPar(uint16_t timeout, int32_t *parPtr, COM_t *comInterface);
+bool getData(uint8_t *data, uint16_t len, COM_t *comInterface);
 /* Command handlers */
 bool startACQ (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool stopACQ (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool syncStart (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool setMode (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool setSamplePeriod (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool setAverageCount (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
@@ -34,6 +39,107 @@ bool DacStop (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool DacStart (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool DacTransfer (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
 bool GetLutCounter(int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setSpectrum (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool startSweep (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setHistogram (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getHistogram (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setCalibration (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setAsciiFormat (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setEncoding (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setDeadband (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setLatency (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool setBlockLatency (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getProfile (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getStatus (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getTrace (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getMemory (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getCapability (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool getSettings (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+bool applySettings (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Snapshot received with apply settings command. */
+static snapshot_t parSnapshot;
+/** \brief Command line being received, complete line is parsed. */
+static uint8_t parLine[MAX_COMMAND_LENGHT];
+/** \brief Number of bytes received in current line, more than fit if it is too long. */
+static uint16_t parLineLen = 0;
+/** \brief Number of binary data bytes which follow command, 0 for text command. */
+static uint16_t parDataLen = 0;
+/** \brief Time last byte of binary data was received, in ms since boot. */
+static uint32_t parLineTime = 0;
+/** \brief Number of bytes of complete line. */
+static uint8_t parLineEnd = 0;
+/** \brief Next byte of complete line read by parser. */
+static uint8_t parLineIdx = 0;
+
+
+/************************************************************************************//**
+** \brief     Reads received bytes to command line, as many as are available. Parsing
+**            never waits for the rest of a command, bytes of a partial line wait for the
+**            next call. Line ends with '\r', binary data of s command ends with the byte
+**            after it. Line feed at start of line is skipped, bytes of a too long line
+**            are dropped so it fails to parse. If binary data stops for more than
+**            PARAMETER_TIMEOUT ms, the partial line fails to parse once the next byte is
+**            received and that byte starts a new line.
+** \param     Pointer to interface module, first byte of complete line.
+** \return    True if line is complete, false otherwise.
+**
+****************************************************************************************/
+bool parserGetLine(COM_t *comInterface, uint8_t *CMD)
+{
+  uint8_t newChar;
+
+  while(comInterface->available())
+  {
+    /* Rest of binary data was lost, do not take next command for it. */
+    if(parLineLen && parDataLen &&
+       ((statusGetUptime() - parLineTime) > PARAMETER_TIMEOUT))
+    {
+      return parEndLine(CMD);
+    }
+    newChar = comInterface->read();
+    parLineTime = statusGetUptime();
+    if(!parLineLen)
+    {
+      /* Line feed after end of previous command. */
+      if(newChar == '\n')
+      {
+        continue;
+      }
+      parDataLen = (newChar == CMD_APPLY_SETTINGS) ? sizeof(snapshot_t) : 0;
+    }
+    if(parLineLen < MAX_COMMAND_LENGHT)
+    {
+      parLine[parLineLen] = newChar;
+    }
+    parLineLen++;
+    /* Every byte of binary data may be '\r'. */
+    if(parDataLen ? (parLineLen > parDataLen + 1) : (newChar == '\r'))
+    {
+      return parEndLine(CMD);
+    }
+  }
+  return false;
+} /*** end of parserGetLine ***/
+
+/************************************************************************************//**
+** \brief     Ends current line, parser reads the rest of it after its first byte.
+** \param     First byte of the line.
+** \return    True.
+**
+****************************************************************************************/
+bool parEndLine(uint8_t *CMD)
+{
+  parLineEnd = (parLineLen < MAX_COMMAND_LENGHT) ? parLineLen : MAX_COMMAND_LENGHT;
+  parLineLen = 0;
+  parLineIdx = 1;
+  *CMD = parLine[0];
+  return true;
+} /*** end of parEndLine ***/
 
 
 /************************************************************************************//**
@@ -67,6 +173,15 @@ bool parseCommand (uint8_t CMD, CMD_t *parsedCMD, COM_t *comInterface)
       result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
       break;
     
+    case CMD_SYNC_START:
+      /* Save command if needed later */
+      parsedCMD->cmd = CMD_SYNC_START;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = syncStart;
+      /* wait for termination of line */
+      result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
+      break;
+    
     case CMD_SET_MODE:
       /* Save command if needed later */
       parsedCMD->cmd = CMD_SET_MODE;
@@ -211,6 +326,159 @@ bool parseCommand (uint8_t CMD, CMD_t *parsedCMD, COM_t *comInterface)
       result = getPar(0, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
       break;	
     
+    case CMD_SET_SPECTRUM:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_SPECTRUM;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setSpectrum;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(3, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_FRA_SWEEP:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_FRA_SWEEP;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = startSweep;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(5, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_HISTOGRAM:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_HISTOGRAM;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setHistogram;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_GET_HISTOGRAM:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_HISTOGRAM;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getHistogram;
+      /* wait for termination of line */
+      result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
+      break;
+    
+    case CMD_CALIBRATION:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_CALIBRATION;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setCalibration;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_ASCII_FORMAT:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_ASCII_FORMAT;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setAsciiFormat;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(3, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_ENCODING:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_ENCODING;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setEncoding;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_DEADBAND:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_DEADBAND;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setDeadband;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(2, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_LATENCY:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_LATENCY;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setLatency;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_SET_BLOCK_LATENCY:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_SET_BLOCK_LATENCY;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = setBlockLatency;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_GET_PROFILE:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_PROFILE;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getProfile;
+      /* Parameter may be left out, table is only sent then. */
+      result = getOptPar(PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_GET_STATUS:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_STATUS;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getStatus;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_GET_TRACE:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_TRACE;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getTrace;
+      /* Get parameters for command or wait for termination of line. */
+      result = getPar(1, PARAMETER_TIMEOUT, parsedCMD->par, comInterface);
+      break;
+    
+    case CMD_GET_MEMORY:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_MEMORY;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getMemory;
+      /* wait for termination of line */
+      result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
+      break;
+    
+    case CMD_GET_CAPABILITY:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_CAPABILITY;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getCapability;
+      /* wait for termination of line */
+      result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
+      break;
+    
+    case CMD_GET_SETTINGS:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_GET_SETTINGS;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = getSettings;
+      /* wait for termination of line */
+      result = getPar(0, PARAMETER_TIMEOUT, NULL, comInterface);
+      break;
+    
+    case CMD_APPLY_SETTINGS:
+      /* Save command if needed later */
+      parsedCMD->cmd =  CMD_APPLY_SETTINGS;
+      /* Set pointer to the command handler */
+      parsedCMD->funcPtr = applySettings;
+      /* Get binary snapshot and wait for termination of line. */
+      result = getData((uint8_t *)&parSnapshot, sizeof(snapshot_t), comInterface);
+      break;
+    
     /* Command not supported */
     default:
       /* Reset command */
@@ -225,7 +493,7 @@ bool parseCommand (uint8_t CMD, CMD_t *parsedCMD, COM_t *comInterface)
 
 
 /************************************************************************************//**
-** \brief     Get parameters and wait for termination of line.
+** \brief     Get parameters from complete command line up to its termination.
 ** \param     Number of required parameters, timeout, pointer to par array in CMD
 **            structure, pointer to interface module.
 ** \return    True if successful, false otherwise.
@@ -249,12 +517,9 @@ bool getPar(uint8_t parCount, uint16_t timeout, int32_t *parPtr, COM_t *comInter
   /* Wait for complete parameters or timeout. */
   while(!result && timeout)
   {
-    /* Was new char received? */
-    if(comInterface->available())
+    /* Get the char from command line */
+    if(parRead(&newChar))
     {
-      /* Get the char */
-      newChar = comInterface->read();
-      
       /* End of command */
       if(newChar == '\r')
       {
@@ -312,11 +577,10 @@ bool getPar(uint8_t parCount, uint16_t timeout, int32_t *parPtr, COM_t *comInter
       /* Reset char */
       newChar = 0;
     }
-    /* Otherwise wait for 1ms before checking again. */
+    /* Line is too long, end of command was dropped. */
     else
     {
-      //delay(1);
-      //timeout--;
+      timeout = 0;
     }
   }
   /* Return result */
@@ -324,6 +588,74 @@ bool getPar(uint8_t parCount, uint16_t timeout, int32_t *parPtr, COM_t *comInter
 } /*** end of getPar ***/
 
 
+/************************************************************************************//**
+** \brief     Get one parameter which may be left out, it is 0 then. Spaces may come
+**            before termination of line of a command without parameter.
+** \param     Timeout, pointer to parameter, pointer to interface module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getOptPar(uint16_t timeout, int32_t *parPtr, COM_t *comInterface)
+{
+  uint8_t idx = parLineIdx;
+
+  while((idx < parLineEnd) && (parLine[idx] == ' '))
+  {
+    idx++;
+  }
+  /* Command without parameter. */
+  if((idx < parLineEnd) && (parLine[idx] == '\r'))
+  {
+    parLineIdx = idx + 1;
+    *parPtr = 0;
+    return TRUE;
+  }
+  return getPar(1, timeout, parPtr, comInterface);
+} /*** end of getOptPar ***/
+
+
+/************************************************************************************//**
+** \brief     Get binary data of given length from complete command line, termination
+**            of line follows it. Every byte value is data, so data can not be edited
+**            with backspace.
+** \param     Pointer to data buffer, number of data bytes, pointer to interface module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getData(uint8_t *data, uint16_t len, COM_t *comInterface)
+{
+  uint8_t newChar;
+
+  /* Get data bytes from command line */
+  for(uint16_t idx = 0; idx < len; idx++)
+  {
+    if(!parRead(&data[idx]))
+    {
+      return FALSE;
+    }
+  }
+  /* Only end of command may follow data. */
+  return parRead(&newChar) && (newChar == '\r');
+} /*** end of getData ***/
+
+
+/************************************************************************************//**
+** \brief     Reads next byte of complete command line.
+** \param     Pointer to read byte.
+** \return    True if successful, false at the end of line.
+**
+****************************************************************************************/
+bool parRead(uint8_t *newChar)
+{
+  if(parLineIdx >= parLineEnd)
+  {
+    return FALSE;
+  }
+  *newChar = parLine[parLineIdx++];
+  return TRUE;
+} /*** end of parRead ***/
+
+
 /************************************************************************************//**
 ** \brief     Start acquisition
 ** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
@@ -333,6 +665,14 @@ bool getPar(uint8_t parCount, uint16_t timeout, int32_t *parPtr, COM_t *comInter
 ****************************************************************************************/
 bool startACQ (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
 {
+  /* CSV index and report time start from 0 with every acquisition */
+  if((settings->mode == CSV_MODE) || (settings->mode == DEADBAND_MODE))
+  {
+    /* Text of previous acquisition which was not sent yet is dropped. */
+    txDropFrames();
+    csvReset();
+    deadbandReset();
+  }
   /* Start core */
   timerStart();
   /* Print msg to inform user */
@@ -353,12 +693,57 @@ bool stopACQ (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
 {
   /* Stop core */
   timerStop();
+  /* Abort frequency sweep if running */
+  fraStop();
+  /* Abort coherent averaging if running */
+  coherentStop();
   /* Print msg to inform user */
+  if(settings->mode == CSV_MODE)
+  {
+    /* Queue the rest of CSV text, the message goes between two lines. */
+    csvSend();
+    comInterface->len = sprintf((char*)comInterface->buf,
+                                "Acquisition stopped, %lu CSV lines dropped\n\r",
+                                (unsigned long)csvGetOverruns());
+    return TRUE;
+  }
+  if(settings->mode == DEADBAND_MODE)
+  {
+    /* Reports are queued right away, only reports which did not fit may wait. */
+    csvSend();
+  }
   comInterface->len = sprintf((char*)comInterface->buf, "Acquisition stopped\n\r");
   return TRUE;
 } /*** end of StopACQ ***/
 
 
+/************************************************************************************//**
+** \brief     Start ADC and DAC with the same timer trigger. Reports offset between
+**            first ADC and first DAC trigger, it is the same on every start.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool syncStart (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  uint32_t adcDelay, dacDelay;
+  /* DAC timer triggers ADC in these modes, they are started with DAC start. */
+  if(fraIsActive() || (settings->mode == COHERENT_MODE))
+  {
+    return FALSE;
+  }
+  /* Start core */
+  timerSyncStart(&adcDelay, &dacDelay);
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "ADC and DAC started, ADC is %ld ns after DAC\n\r",
+                              (long)(adcDelay - dacDelay));
+  /* Set result */
+  return TRUE;
+} /*** end of syncStart ***/
+
+
 /************************************************************************************//**
 ** \brief     Start acquisition in binary
 ** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
@@ -371,8 +756,16 @@ bool setMode (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
   /* Is parameter is range? */
   if(*parPtr >= MODE_LOWRANGE && *parPtr <= MODE_HIGHRANGE)
   {
+    /* Modes share workspace, results of previous mode are dropped. */
+    txDropFrames();
+    coherentReset();
+    spectrumReset();
+    histogramReset();
+    csvReset();
+    deadbandReset();
     /* Set parameter */
     settings->mode = (uint8_t)*parPtr;
+    coreSelectDataCom();
     /* Print msg to inform user */
     switch((uint8_t)*parPtr)
     {
@@ -385,6 +778,34 @@ bool setMode (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
         comInterface->len = sprintf((char*)comInterface->buf,
                                     "Acquisition started in binary\n\r");
         break;
+      
+      case SPECTRUM_MODE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "Acquisition started in spectrum mode\n\r");
+        break;
+      
+      case COHERENT_MODE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "Acquisition started in coherent mode\n\r");
+        break;
+      
+      case HISTOGRAM_MODE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "Acquisition started in histogram mode\n\r");
+        break;
+      
+      case CSV_MODE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "Acquisition started in CSV mode, "
+                                    "minimum sample period %lu us\n\r",
+                                    (unsigned long)csvGetMinPeriod(settings));
+        break;
+      
+      case DEADBAND_MODE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "Acquisition started in report by "
+                                    "exception mode\n\r");
+        break;
     }
     return TRUE;
   }
@@ -658,6 +1079,20 @@ bool DacSetNumberOfRepeats (int32_t *parPtr,daq_settings_t *settings,COM_t *comI
 ****************************************************************************************/
 bool DacStart (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
 {
+  /* Coherent averaging starts ADC together with DAC. */
+  if(settings->mode == COHERENT_MODE)
+  {
+    if(!coherentStart(settings))
+    {
+      return false;
+    }
+    /* Print msg to inform user */
+    comInterface->len = sprintf((char*)comInterface->buf,
+                                "DAC timer started, averaging %u samples\n\r",
+                                (uint16_t)*settings->blockSize);
+    /* Return true */
+    return true;
+  }
   /* Call core handler */
   dacTimerStart();
   /* Print msg to inform user */
@@ -678,6 +1113,8 @@ bool DacStop (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
 {
   /* Call core handler */
   dacTimerStop();
+  /* Abort coherent averaging if running */
+  coherentStop();
   /* Print msg to inform user */
   comInterface->len = sprintf((char*)comInterface->buf, "DAC timer stopped\n\r");
   /* Return true */
@@ -782,4 +1219,517 @@ bool GetLutCounter(int32_t *parPtr, daq_settings_t *settings, COM_t *comInterfac
 } /*** end of GetLutCounter ***/
 
 
+/************************************************************************************//**
+** \brief     setSpectrum
+**            Sets FFT length, spectrum output type and number of averaged spectra for
+**            spectrum mode. Block size is set so every block holds all FFT points of
+**            each enabled channel.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setSpectrum (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* 1. Parameter: FFT length, power of two. */
+  int32_t points = *(parPtr + 0);
+  /* Block size needed for all FFT points of enabled channels. */
+  int32_t blockSize = points * coreGetChannelCount();
+  
+  /* Is parameter is range? */
+  if( (points < DSP_FFT_MIN_POINTS) || (points > DSP_FFT_MAX_POINTS) ||
+      (points & (points - 1)) ||
+      ( (*(parPtr + 1) != SPECTRUM_MAGNITUDE) && (*(parPtr + 1) != SPECTRUM_POWER) ) ||
+      (*(parPtr + 2) < SPECTRUM_AVERAGES_LOWRANGE) ||
+      (*(parPtr + 2) > SPECTRUM_AVERAGES_HIGHRANGE) )
+  {
+    return FALSE;
+  }
+  /* Set block size, fails if FFT is too long for the enabled channels. */
+  if(!setBlockSize(&blockSize, settings, comInterface))
+  {
+    return FALSE;
+  }
+  /* Set parameters */
+  settings->fftPoints = (uint16_t)points;
+  settings->spectrumType = (uint8_t)*(parPtr + 1);
+  settings->spectrumAverages = (uint16_t)*(parPtr + 2);
+  /* Start averaging from scratch. */
+  spectrumReset();
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "Spectrum set to %u points, %s, %u averages\n\r",
+                              settings->fftPoints,
+                              settings->spectrumType ? "power" : "magnitude",
+                              settings->spectrumAverages);
+  /* Return true */
+  return true;
+} /*** end of setSpectrum ***/
+
+
+/************************************************************************************//**
+** \brief     startSweep
+**            Starts logarithmic frequency response sweep. DAC outputs a sine on both
+**            channels and enabled ADC channels are demodulated on device. Gain and
+**            phase are sent for every point.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool startSweep (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if( (*(parPtr + 0) < 1) || (*(parPtr + 1) < 1) ||
+      (*(parPtr + 2) < 1) || (*(parPtr + 2) > FRA_POINTS_HIGHRANGE) ||
+      (*(parPtr + 3) < 1) || (*(parPtr + 3) > FRA_PERIODS_HIGHRANGE) ||
+      (*(parPtr + 4) < 1) )
+  {
+    return FALSE;
+  }
+  /* Call core handler, it checks frequency and amplitude limits. */
+  if(!fraStart((uint32_t)*(parPtr + 0), (uint32_t)*(parPtr + 1), (uint16_t)*(parPtr + 2),
+               (uint16_t)*(parPtr + 3), (uint16_t)*(parPtr + 4), settings))
+  {
+    return FALSE;
+  }
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "Sweep started, %u points\n\r", (uint16_t)*(parPtr + 2));
+  /* Return true */
+  return true;
+} /*** end of startSweep ***/
+
+
+/************************************************************************************//**
+** \brief     setHistogram
+**            Sets number of blocks accumulated before histogram is sent. With 0 it is
+**            only sent on request (or before its bins would overflow).
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setHistogram (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*(parPtr + 0) < 0 || *(parPtr + 0) > HISTOGRAM_PERIOD_HIGHRANGE)
+  {
+    return FALSE;
+  }
+  /* Set parameter */
+  settings->histogramPeriod = (uint16_t)*(parPtr + 0);
+  /* Start counting from scratch. */
+  histogramReset();
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "Histogram period set to %u blocks, %u bins\n\r",
+                              settings->histogramPeriod, histogramGetBins(settings));
+  /* Return true */
+  return true;
+} /*** end of setHistogram ***/
+
+
+/************************************************************************************//**
+** \brief     getHistogram
+**            Sends histogram accumulated since it was last sent.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getHistogram (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  uint8_t *sync;
+  /* Only in histogram mode. */
+  if(settings->mode != HISTOGRAM_MODE)
+  {
+    return FALSE;
+  }
+  /* Nothing accumulated yet. */
+  sync = histogramRequest();
+  if(sync == NULL)
+  {
+    return FALSE;
+  }
+  /* Histogram is sent after its sync bytes as data frame, there is no reply. */
+  comInterface->len = 0;
+  /* Return true */
+  return true;
+} /*** end of getHistogram ***/
+
+
+/************************************************************************************//**
+** \brief     setCalibration
+**            Enables or disables correction of sent samples, or measures correction
+**            of every enabled channel and gain through DAC to ADC loopback first.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setCalibration (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  uint8_t done;
+  /* Is parameter is range? */
+  if(*(parPtr + 0) < CAL_OFF || *(parPtr + 0) > CAL_RUN)
+  {
+    return FALSE;
+  }
+  if(*(parPtr + 0) == CAL_RUN)
+  {
+    /* Sweep and averaging use DAC, stop them first. */
+    fraStop();
+    coherentStop();
+    /* Call core handler */
+    done = calRun(settings);
+    settings->calibration = CAL_ON;
+    /* Print msg to inform user */
+    comInterface->len = sprintf((char*)comInterface->buf,
+                                "Calibration done, %u channel gains calibrated\n\r",
+                                done);
+    return TRUE;
+  }
+  /* Set parameter */
+  settings->calibration = (uint8_t)*(parPtr + 0);
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf, "Calibration correction %s\n\r",
+                              settings->calibration ? "enabled" : "disabled");
+  /* Return true */
+  return true;
+} /*** end of setCalibration ***/
+
+
+/************************************************************************************//**
+** \brief     Set unit and separator of values in ASCII mode, unit and index column in
+**            CSV mode.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setAsciiFormat (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*(parPtr + 0) < ASCII_UNIT_MV || *(parPtr + 0) > ASCII_UNIT_UV ||
+     *(parPtr + 1) < ASCII_SEPARATOR_SPACE || *(parPtr + 1) > ASCII_SEPARATOR_COMMA ||
+     *(parPtr + 2) < CSV_INDEX_OFF || *(parPtr + 2) > CSV_INDEX_ON)
+  {
+    return FALSE;
+  }
+  /* Set parameters */
+  settings->asciiUnit = (uint8_t)*(parPtr + 0);
+  settings->asciiSeparator = (uint8_t)*(parPtr + 1);
+  settings->csvIndex = (uint8_t)*(parPtr + 2);
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "ASCII values in %s separated by %s, CSV index %s\n\r",
+                              settings->asciiUnit ? "uV" : "mV",
+                              settings->asciiSeparator ? "comma" : "space",
+                              settings->csvIndex ? "on" : "off");
+  /* Return true */
+  return true;
+} /*** end of setAsciiFormat ***/
+
+
+/************************************************************************************//**
+** \brief     Set encoding of samples in BIN mode.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setEncoding (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*parPtr >= PACK_OFF && *parPtr <= PACK_RICE)
+  {
+    /* Set parameter */
+    settings->encoding = (uint8_t)*parPtr;
+    /* Print msg to inform user */
+    switch(settings->encoding)
+    {
+      case PACK_OFF:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "BIN samples in 16-bit words\n\r");
+        break;
+      
+      case PACK_ON:
+        comInterface->len = sprintf((char*)comInterface->buf, "BIN samples packed\n\r");
+        break;
+      
+      case PACK_RICE:
+        comInterface->len = sprintf((char*)comInterface->buf,
+                                    "BIN samples compressed\n\r");
+        break;
+    }
+    /* Return true */
+    return TRUE;
+  }
+  
+  return FALSE;
+} /*** end of setEncoding ***/
+
+
+/************************************************************************************//**
+** \brief     Set deadband and heartbeat period of report by exception mode.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setDeadband (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*(parPtr + 0) < 0 || *(parPtr + 0) > DEADBAND_MAX ||
+     *(parPtr + 1) < 0 || *(parPtr + 1) > DEADBAND_HEARTBEAT_MAX)
+  {
+    return FALSE;
+  }
+  /* Set parameters */
+  settings->deadband = (uint16_t)*(parPtr + 0);
+  settings->heartbeat = (uint32_t)*(parPtr + 1);
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "Deadband set to %u codes, heartbeat every %lu s\n\r",
+                              settings->deadband, (unsigned long)settings->heartbeat);
+  /* Return true */
+  return true;
+} /*** end of setDeadband ***/
+
+
+/************************************************************************************//**
+** \brief     Set time data waits on the data interface to fill a whole USB transfer.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setLatency (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*parPtr < 0 || *parPtr > VENDOR_LATENCY_MAX)
+  {
+    return FALSE;
+  }
+  /* Set parameter */
+  settings->latency = (uint16_t)*parPtr;
+  vendorSetLatency(settings->latency);
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf, "Latency set to %u ms\n\r",
+                              settings->latency);
+  /* Return true */
+  return true;
+} /*** end of setLatency ***/
+
+
+/************************************************************************************//**
+** \brief     Set time samples wait for their block to complete, then they are sent as
+**            part of a block.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool setBlockLatency (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*parPtr < 0 || *parPtr > CORE_BLOCK_LATENCY_MAX)
+  {
+    return FALSE;
+  }
+  /* Set parameter */
+  settings->blockLatency = (uint16_t)*parPtr;
+  /* Print msg to inform user */
+  if(settings->blockLatency)
+  {
+    comInterface->len = sprintf((char*)comInterface->buf,
+                                "Partial blocks sent after %u ms\n\r",
+                                settings->blockLatency);
+  }
+  else
+  {
+    comInterface->len = sprintf((char*)comInterface->buf, "Partial blocks off\n\r");
+  }
+  /* Return true */
+  return true;
+} /*** end of setBlockLatency ***/
+
+
+/************************************************************************************//**
+** \brief     getProfile
+**            Sends number of calls and minimum, mean and maximum cycles of interrupts
+**            and processing stages. Available only in builds with PROFILE defined.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getProfile (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+#ifdef PROFILE
+  /* Is parameter is range? */
+  if(*parPtr < 0 || *parPtr > 1)
+  {
+    return FALSE;
+  }
+  /* Table is sent line by line, 1 clears it afterwards. Cut table is an error. */
+  if(!profileReport(comInterface, *parPtr == 1))
+  {
+    return FALSE;
+  }
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf, (*parPtr == 1) ?
+                              "Profile cleared\n\r" : "Profile end\n\r");
+  /* Return true */
+  return true;
+#else
+  /* Profiling is not built in. */
+  return FALSE;
+#endif
+} /*** end of getProfile ***/
+
+
+/************************************************************************************//**
+** \brief     getStatus
+**            Sends status record (status_record_t) with health and throughput counters
+**            as binary reply. Acquisition is not stopped.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getStatus (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Is parameter is range? */
+  if(*parPtr < 0 || *parPtr > 1)
+  {
+    return FALSE;
+  }
+  /* Record is the reply, 1 clears counters after they are read. */
+  statusGetRecord((status_record_t *)comInterface->buf, *parPtr == 1);
+  comInterface->len = sizeof(status_record_t);
+  /* Return true */
+  return true;
+} /*** end of getStatus ***/
+
+
+/************************************************************************************//**
+** \brief     getTrace
+**            Sends event trace as binary data frame on the data interface, it is
+**            decoded by host/trace_decode. Events are not recorded until it is sent.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getTrace (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+#ifdef TRACE
+  /* Is parameter is range? */
+  if(*parPtr < 0 || *parPtr > 1)
+  {
+    return FALSE;
+  }
+  /* 1 clears trace after it is sent. */
+  if(!traceDump(*parPtr == 1))
+  {
+    return FALSE;
+  }
+  /* Data frame is the reply. */
+  comInterface->len = 0;
+  /* Return true */
+  return true;
+#else
+  /* Trace is not built in. */
+  return FALSE;
+#endif
+} /*** end of getTrace ***/
+
+
+/************************************************************************************//**
+** \brief     getMemory
+**            Sends SRAM usage: static data, stack high-water mark since boot and stack
+**            size, then size and address of the largest free region.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getMemory (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf,
+                              "RAM static %lu stack %lu/%lu free %lu at 0x%08lX\n\r",
+                              (unsigned long)memoryStatic(),
+                              (unsigned long)memoryStackUsed(),
+                              (unsigned long)memoryStackSize(),
+                              (unsigned long)memoryFree(),
+                              (unsigned long)memoryFreeStart());
+  /* Return true */
+  return true;
+} /*** end of getMemory ***/
+
+
+/************************************************************************************//**
+** \brief     getCapability
+**            Sends capability descriptor (capability_t) as binary reply: versions,
+**            buffer sizes, supported modes and encodings, clocks and throughput.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getCapability (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Descriptor is the reply. */
+  capabilityGet((capability_t *)comInterface->buf);
+  comInterface->len = sizeof(capability_t);
+  /* Return true */
+  return true;
+} /*** end of getCapability ***/
+
+
+/************************************************************************************//**
+** \brief     getSettings
+**            Sends all active settings as binary snapshot (snapshot_t). LUT values are
+**            not part of it.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool getSettings (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Snapshot is the reply. */
+  snapshotGet(settings, (snapshot_t *)comInterface->buf);
+  comInterface->len = sizeof(snapshot_t);
+  /* Return true */
+  return true;
+} /*** end of getSettings ***/
+
+
+/************************************************************************************//**
+** \brief     applySettings
+**            Applies all settings from received binary snapshot. Snapshot is checked
+**            first, if any value is out of range nothing is changed.
+** \param     Pointer to par array in CMD, pointer to daq settings, pointer to interface
+**            module.
+** \return    True if successful, false otherwise.
+**
+****************************************************************************************/
+bool applySettings (int32_t *parPtr, daq_settings_t *settings, COM_t *comInterface)
+{
+  /* Call snapshot handler */
+  if(!snapshotApply(settings, &parSnapshot))
+  {
+    return FALSE;
+  }
+  /* Print msg to inform user */
+  comInterface->len = sprintf((char*)comInterface->buf, "Settings applied\n\r");
+  /* Return true */
+  return true;
+} /*** end of applySettings ***/
+
+
 /*********************************** end of parser.c ***********************************/
\ No newline at end of file
@@ -11,6 +11,23 @@
 ****************************************************************************************/
 #include "core.h"                            /* Core functionality for acquisition     */
 #include "comInterface.h"                    /* USB interface driver                   */
+#include "spectrum.h"                        /* Spectrum mode                          */
+#include "fra.h"                             /* Frequency response analyser            */
+#include "coherent.h"                        /* Coherent averaging mode                */
+#include "histogram.h"                       /* Histogram mode                         */
+#include "calibration.h"                     /* Loopback calibration                   */
+#include "ascii.h"                           /* Text output                            */
+#include "csv.h"                             /* CSV streaming mode                     */
+#include "pack.h"                            /* Packed sample encoding                 */
+#include "deadband.h"                        /* Report by exception mode               */
+#include "tx.h"                              /* Transmit arbiter                       */
+#include "vendor.h"                          /* Vendor bulk streaming interface        */
+#include "profile.h"                         /* Cycle counter profiling                */
+#include "status.h"                          /* Health and throughput counters         */
+#include "trace.h"                           /* Event trace                            */
+#include "memory.h"                          /* SRAM usage measurement                 */
+#include "capability.h"                      /* Capability descriptor                  */
+#include "snapshot.h"                        /* Settings snapshot                      */
 
 
 /****************************************************************************************
@@ -27,6 +44,8 @@
 #define CMD_START_ACQ               'S'
 /** \brief Command will stop ADC sampling. */
 #define CMD_STOP_ACQ                'T'
+/** \brief Command will start ADC and DAC sampling at the same time */
+#define CMD_SYNC_START              'D'
 /** \brief Command will set number of averageing */
 #define CMD_SET_AVERAGE_COUNT       'A'
 /** \brief Command will set time between samples */
@@ -60,20 +79,60 @@
 #define CMD_DAC_TRANSFER_MODE       'P'
 /** \brief Command will send DAC LUT counter value */
 #define CMD_DAC_LUT_COUNTER         'U'
+/* Processing commands */
+/** \brief Command will set FFT length, output and averaging of spectrum mode */
+#define CMD_SET_SPECTRUM            'W'
+/** \brief Command will start frequency response sweep */
+#define CMD_FRA_SWEEP               'Y'
+/** \brief Command will set histogram sending period */
+#define CMD_SET_HISTOGRAM           'V'
+/** \brief Command will send histogram */
+#define CMD_GET_HISTOGRAM           'X'
+/** \brief Command will calibrate ADC with DAC or enable calibration correction */
+#define CMD_CALIBRATION             'Z'
+/** \brief Command will set unit, separator and index column of ASCII and CSV mode */
+#define CMD_SET_ASCII_FORMAT        'I'
+/** \brief Command will set encoding of samples in BIN mode */
+#define CMD_SET_ENCODING            'Q'
+/** \brief Command will set deadband and heartbeat of report by exception mode */
+#define CMD_SET_DEADBAND            'd'
+/** \brief Command will set time data waits to fill USB transfer */
+#define CMD_SET_LATENCY             'l'
+/** \brief Command will set time samples wait for block to complete */
+#define CMD_SET_BLOCK_LATENCY       'p'
+/* Diagnostic commands */
+/** \brief Command will send cycle counts of interrupts and processing stages */
+#define CMD_GET_PROFILE             'c'
+/** \brief Command will send binary status record with health and throughput counters */
+#define CMD_GET_STATUS              'h'
+/** \brief Command will send trace of interrupts and USB events as binary data frame */
+#define CMD_GET_TRACE               't'
+/** \brief Command will send static data size, stack high-water mark and free SRAM */
+#define CMD_GET_MEMORY              'm'
+/** \brief Command will send binary descriptor of limits, clocks and throughput */
+#define CMD_GET_CAPABILITY          'i'
+
+/* Settings snapshot commands */
+/** \brief Command will send all active settings as binary snapshot */
+#define CMD_GET_SETTINGS            'g'
+/** \brief Command will apply all settings from binary snapshot which follows it */
+#define CMD_APPLY_SETTINGS          's'
 
 /* Parameter limits */
 /** \brief Maximum number of parameters supported */
-#define MAX_PARAMETER_COUNT         4
+#define MAX_PARAMETER_COUNT         5
 /** \brief Maximum parameter length "9999999" */
 #define MAX_PARAMETER_LENGHT        7
 /** \brief Maximum time to wait for all parameters*/
 #define PARAMETER_TIMEOUT           100
+/** \brief Maximum command length with end of line, s command with snapshot is longest */
+#define MAX_COMMAND_LENGHT          64
 
 /* Parameter ranges */
 /** \brief Parameter mode minimum value */
 #define MODE_LOWRANGE               0
 /** \brief Parameter mode maximum value */
-#define MODE_HIGHRANGE              1
+#define MODE_HIGHRANGE              6
 /** \brief Parameter sample period minimum value */
 #define SAMPLE_PERIOD_LOWRANGE      1
 /** \brief Parameter sample period maximum value */
@@ -122,12 +181,32 @@
 #define DAC_PERIOD_MIN              1
 /** \brief Parameter DAC maximum sample period */
 #define DAC_PERIOD_MAX              0xFFFF
+/** \brief Parameter minimum number of averaged spectra */
+#define SPECTRUM_AVERAGES_LOWRANGE  1
+/** \brief Parameter maximum number of averaged spectra */
+#define SPECTRUM_AVERAGES_HIGHRANGE 1000
+/** \brief Parameter maximum number of blocks between histograms */
+#define HISTOGRAM_PERIOD_HIGHRANGE  0xFFFF
+/** \brief Parameter maximum number of sweep points */
+#define FRA_POINTS_HIGHRANGE        1000
+/** \brief Parameter maximum number of stimulus periods per sweep point */
+#define FRA_PERIODS_HIGHRANGE       1000
 
 /* Communication mode defines */
 /** \brief Parameter ASCII mode value */
 #define ASCII_MODE                  0
 /** \brief Parameter BIN mode value */
 #define BIN_MODE                    1
+/** \brief Parameter spectrum mode value */
+#define SPECTRUM_MODE               2
+/** \brief Parameter coherent averaging mode value */
+#define COHERENT_MODE               3
+/** \brief Parameter histogram mode value */
+#define HISTOGRAM_MODE              4
+/** \brief Parameter CSV streaming mode value */
+#define CSV_MODE                    5
+/** \brief Parameter report by exception mode value */
+#define DEADBAND_MODE               6
 
 
 /****************************************************************************************
@@ -147,6 +226,7 @@ typedef struct
 * Function prototypes
 ****************************************************************************************/
 /* Parser function */
+bool parserGetLine(COM_t *comInterface, uint8_t *CMD);
 bool parseCommand (uint8_t CMD, CMD_t *parsedCMD, COM_t *comInterface);
 
 
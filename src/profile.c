@@ -0,0 +1,139 @@
+/************************************************************************************//**
+* \file     profile.c
+* \brief    This module implements cycle counter profiling of interrupts and processing
+*           stages. DWT cycle counter is read at start and end of measured code, calls
+*           and minimum, mean and maximum number of cycles are kept for every item.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "profile.h"                 /* Cycle counter profiling                        */
+#include "tx.h"                      /* Transmit arbiter                               */
+
+#ifdef PROFILE
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Statistics of one measured item */
+typedef struct
+{
+  uint32_t calls;                    /* Number of measurements                         */
+  uint32_t min;                      /* Least cycles                                   */
+  uint32_t max;                      /* Most cycles                                    */
+  uint64_t sum;                      /* Cycles of all measurements                     */
+}profile_slot_t;
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Statistics of every measured item. */
+static profile_slot_t profileSlots[PROFILE_SLOTS];
+/** \brief Names of measured items, in the same order. */
+static const char *profileNames[PROFILE_SLOTS] =
+{
+  "adcIsr", "daccIsr", "txEmpty", "rxNotify", "block", "calApply", "format", "average",
+  "pack", "txPump", "command", "flush"
+};
+
+
+/****************************************************************************************
+*                                     P R O F I L E
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Enables DWT cycle counter and clears statistics.
+**
+****************************************************************************************/
+void profileInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  for(uint8_t slot = 0; slot < PROFILE_SLOTS; slot++)
+  {
+    profileSlots[slot].calls = 0;
+  }
+} /*** end of profileInit ***/
+
+/************************************************************************************//**
+** \brief     Adds one measurement to statistics of the item. Called from every
+**            priority, so interrupts are disabled for the few instructions it takes.
+** \param     slot Measured item.
+** \param     cycles Number of cycles.
+**
+****************************************************************************************/
+void profileRecord(uint8_t slot, uint32_t cycles)
+{
+  profile_slot_t *p = &profileSlots[slot];
+  irqflags_t flags = cpu_irq_save();
+
+  if(!p->calls || (cycles < p->min))
+  {
+    p->min = cycles;
+  }
+  if(!p->calls || (cycles > p->max))
+  {
+    p->max = cycles;
+  }
+  if(!p->calls)
+  {
+    p->sum = 0;
+  }
+  p->sum += cycles;
+  p->calls++;
+  cpu_irq_restore(flags);
+} /*** end of profileRecord ***/
+
+/************************************************************************************//**
+** \brief     Sends statistics as command replies, one line per measured item which was
+**            called: name, calls, minimum, mean and maximum cycles. Items which were
+**            never called are left out. Every line is written to the interface when it
+**            is queued, so the table does not have to fit to reply buffer at once.
+** \param     comInterface Interface which holds reply buffer.
+** \param     reset Statistics are cleared after they are sent.
+** \return    True if whole table was queued, false if reply buffer was full.
+**
+****************************************************************************************/
+bool profileReport(COM_t *comInterface, bool reset)
+{
+  profile_slot_t p;
+  irqflags_t flags;
+
+  comInterface->len = sprintf((char*)comInterface->buf, "Cycles at %lu Hz\n\r",
+                              (unsigned long)sysclk_get_cpu_hz());
+  if(!txReply(comInterface->buf, comInterface->len))
+  {
+    return false;
+  }
+  for(uint8_t slot = 0; slot < PROFILE_SLOTS; slot++)
+  {
+    flags = cpu_irq_save();
+    p = profileSlots[slot];
+    if(reset)
+    {
+      profileSlots[slot].calls = 0;
+    }
+    cpu_irq_restore(flags);
+    if(!p.calls)
+    {
+      continue;
+    }
+    comInterface->len = sprintf((char*)comInterface->buf, "%s %lu %lu %lu %lu\n\r",
+                                profileNames[slot], (unsigned long)p.calls,
+                                (unsigned long)p.min, (unsigned long)(p.sum / p.calls),
+                                (unsigned long)p.max);
+    if(!txReply(comInterface->buf, comInterface->len))
+    {
+      return false;
+    }
+  }
+  return true;
+} /*** end of profileReport ***/
+
+#endif /* PROFILE */
+
+
+/*********************************** end of profile.c **********************************/
@@ -0,0 +1,74 @@
+/************************************************************************************//**
+* \file     profile.h
+* \brief    This module implements cycle counter profiling of interrupts and processing
+*           stages. It is built only if PROFILE is defined (Debug configuration),
+*           otherwise every macro is empty and nothing is compiled in.
+****************************************************************************************/
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "comInterface.h"            /* USB interface driver                           */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Measured code */
+/** \brief ADC interrupt, PDC re-arm */
+#define PROFILE_ADC_ISR     0
+/** \brief DACC interrupt, LUT restart */
+#define PROFILE_DACC_ISR    1
+/** \brief Transmit empty callback of USB interrupt */
+#define PROFILE_TX_EMPTY    2
+/** \brief Receive callback of USB interrupt */
+#define PROFILE_RX_NOTIFY   3
+/** \brief Whole processing of completed block */
+#define PROFILE_BLOCK       4
+/** \brief Calibration correction of block */
+#define PROFILE_CALIBRATION 5
+/** \brief Text formatting of block */
+#define PROFILE_FORMAT      6
+/** \brief Averaging of block in BIN mode */
+#define PROFILE_AVERAGE     7
+/** \brief Packing or compression of block */
+#define PROFILE_PACK        8
+/** \brief Transmit arbiter writing to interfaces */
+#define PROFILE_TX_PUMP     9
+/** \brief Parsing and execution of commands */
+#define PROFILE_COMMAND     10
+/** \brief Sending part of block which is not complete */
+#define PROFILE_FLUSH       11
+/** \brief Number of measured items */
+#define PROFILE_SLOTS       12
+
+#ifdef PROFILE
+/** \brief Enables cycle counter */
+#define PROFILE_INIT()      profileInit()
+/** \brief Starts measurement, must follow declarations of the function */
+#define PROFILE_START()     uint32_t profileStart = DWT->CYCCNT
+/** \brief Records cycles since PROFILE_START, interrupts which preempted are counted */
+#define PROFILE_STOP(slot)  profileRecord((slot), DWT->CYCCNT - profileStart)
+#else
+#define PROFILE_INIT()
+#define PROFILE_START()
+#define PROFILE_STOP(slot)
+#endif
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+#ifdef PROFILE
+void profileInit(void);
+void profileRecord(uint8_t slot, uint32_t cycles);
+bool profileReport(COM_t *comInterface, bool reset);
+#endif
+
+
+#endif /* PROFILE_H_ */
+/*********************************** end of profile.h **********************************/
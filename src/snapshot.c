@@ -0,0 +1,234 @@
+/************************************************************************************//**
+* \file     snapshot.c
+* \brief    This module implements binary snapshot of DAQ settings. Host reads whole
+*           active configuration at once and applies it back with one command instead
+*           of one command per setting. Snapshot is checked completely before anything
+*           is changed, so it is applied whole or not at all. LUT values are not part
+*           of it, they are loaded with their own command.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "snapshot.h"                /* Settings snapshot                              */
+#include "parser.h"                  /* Command parser and parameter ranges            */
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+bool snapshotCheck(snapshot_t *snapshot);
+
+
+/****************************************************************************************
+*                                    S N A P S H O T
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Fills snapshot with active settings.
+** \param     settings DAQ settings.
+** \param     snapshot Snapshot to fill.
+**
+****************************************************************************************/
+void snapshotGet(daq_settings_t *settings, snapshot_t *snapshot)
+{
+  snapshot->id[0] = 'C';
+  snapshot->id[1] = 'F';
+  snapshot->version = SNAPSHOT_VERSION;
+  snapshot->size = sizeof(snapshot_t);
+  snapshot->samplePeriod = settings->acqusitionTime;
+  snapshot->measurementCount = settings->acquisitionNbr;
+  snapshot->averaging = settings->averaging;
+  snapshot->blockSize = (uint16_t)*settings->blockSize;
+  snapshot->mode = settings->mode;
+  snapshot->encoding = settings->encoding;
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    snapshot->sequence[ch] = settings->sequence[ch];
+    snapshot->adcGain[ch] = settings->ADCgain[ch];
+  }
+  snapshot->adcLowRes = settings->ADClowRes;
+  snapshot->calibration = settings->calibration;
+  snapshot->asciiUnit = settings->asciiUnit;
+  snapshot->asciiSeparator = settings->asciiSeparator;
+  snapshot->csvIndex = settings->csvIndex;
+  snapshot->spectrumType = settings->spectrumType;
+  snapshot->fftPoints = settings->fftPoints;
+  snapshot->spectrumAverages = settings->spectrumAverages;
+  snapshot->histogramPeriod = settings->histogramPeriod;
+  snapshot->deadband = settings->deadband;
+  snapshot->heartbeat = settings->heartbeat;
+  snapshot->latency = settings->latency;
+  snapshot->blockLatency = settings->blockLatency;
+  snapshot->dacPeriod = settings->DacPeriod;
+  snapshot->lutLength = settings->LutLength;
+  snapshot->dacRepeats = settings->NumOfRepeats;
+  snapshot->dacTransferMode = getDacTransferMode();
+  snapshot->reserved = 0;
+} /*** end of snapshotGet ***/
+
+/************************************************************************************//**
+** \brief     Checks every value of snapshot against ranges of the commands which set
+**            it. Values the DAQ starts with are accepted, so a snapshot which was read
+**            can always be applied back. Channel sequence must enable at least one
+**            channel, each once, and have no channel after the first 0.
+** \param     snapshot Received snapshot.
+** \return    True if snapshot can be applied, false otherwise.
+**
+****************************************************************************************/
+bool snapshotCheck(snapshot_t *snapshot)
+{
+  uint8_t channels = 0;
+
+  if((snapshot->id[0] != 'C') || (snapshot->id[1] != 'F') ||
+     (snapshot->version != SNAPSHOT_VERSION) || (snapshot->size != sizeof(snapshot_t)))
+  {
+    return false;
+  }
+  if((snapshot->samplePeriod < SAMPLE_PERIOD_LOWRANGE) ||
+     (snapshot->samplePeriod > SAMPLE_PERIOD_HIGHRANGE) ||
+     (snapshot->measurementCount > MEASURMENT_COUNT_HIGHRANGE) ||
+     (snapshot->averaging > AVERAGE_COUNT_HIGHRANGE) ||
+     (snapshot->blockSize < BLOCK_SIZE_MIN) || (snapshot->blockSize > BLOCK_SIZE_MAX) ||
+     (snapshot->mode > MODE_HIGHRANGE) || (snapshot->encoding > PACK_RICE))
+  {
+    return false;
+  }
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    if((snapshot->sequence[ch] > SEQUENCER_HIGHRANGE) ||
+       (snapshot->adcGain[ch] > ADC_GAIN_2))
+    {
+      return false;
+    }
+    /* Enabled channels come first, every channel is enabled once. */
+    if(snapshot->sequence[ch])
+    {
+      if(channels != ch)
+      {
+        return false;
+      }
+      for(uint8_t prev = 0; prev < ch; prev++)
+      {
+        if(snapshot->sequence[prev] == snapshot->sequence[ch])
+        {
+          return false;
+        }
+      }
+      channels++;
+    }
+  }
+  /* At least one channel must be enabled, otherwise no block completes. */
+  if(!channels)
+  {
+    return false;
+  }
+  if((snapshot->adcLowRes > ADC_RES_10_BITS) || (snapshot->calibration > CAL_ON) ||
+     (snapshot->asciiUnit > ASCII_UNIT_UV) ||
+     (snapshot->asciiSeparator > ASCII_SEPARATOR_COMMA) ||
+     (snapshot->csvIndex > CSV_INDEX_ON) || (snapshot->spectrumType > SPECTRUM_POWER))
+  {
+    return false;
+  }
+  /* Spectrum block holds all FFT points of every enabled channel. */
+  if((snapshot->fftPoints < DSP_FFT_MIN_POINTS) ||
+     (snapshot->fftPoints > DSP_FFT_MAX_POINTS) ||
+     (snapshot->fftPoints & (snapshot->fftPoints - 1)) ||
+     ((snapshot->mode == SPECTRUM_MODE) &&
+      (snapshot->blockSize != snapshot->fftPoints * channels)) ||
+     (snapshot->spectrumAverages < SPECTRUM_AVERAGES_LOWRANGE) ||
+     (snapshot->spectrumAverages > SPECTRUM_AVERAGES_HIGHRANGE))
+  {
+    return false;
+  }
+  if((snapshot->deadband > DEADBAND_MAX) ||
+     (snapshot->heartbeat > DEADBAND_HEARTBEAT_MAX) ||
+     (snapshot->latency > VENDOR_LATENCY_MAX) ||
+     (snapshot->blockLatency > CORE_BLOCK_LATENCY_MAX) ||
+     (snapshot->dacPeriod < DAC_PERIOD_MIN) ||
+     (snapshot->lutLength < 1) ||
+     (snapshot->lutLength > (DAC_LUT_LOCATION_HIGHRANGE + 1) * 2) ||
+     (snapshot->dacTransferMode > 1))
+  {
+    return false;
+  }
+  return true;
+} /*** end of snapshotCheck ***/
+
+/************************************************************************************//**
+** \brief     Applies whole snapshot. Runs in event handler, so blocks are never
+**            processed with part of the settings changed. Results of the mode which
+**            were not sent yet are dropped, like when mode is set.
+** \param     settings DAQ settings.
+** \param     snapshot Received snapshot.
+** \return    True if snapshot was applied, false if nothing was changed.
+**
+****************************************************************************************/
+bool snapshotApply(daq_settings_t *settings, snapshot_t *snapshot)
+{
+  uint32_t samplePeriod = settings->acqusitionTime;
+
+  if(!snapshotCheck(snapshot))
+  {
+    return false;
+  }
+  /* Timer is the only setting which may still fail, it goes first. */
+  settings->acqusitionTime = snapshot->samplePeriod;
+  if(!timerSetTimePeriod())
+  {
+    settings->acqusitionTime = samplePeriod;
+    return false;
+  }
+
+  /* Sweep gives its DAC setup back first, so it does not restore it over snapshot. */
+  fraStop();
+  /* Modes share workspace, results of previous settings are dropped. */
+  txDropFrames();
+  coherentReset();
+  spectrumReset();
+  histogramReset();
+  csvReset();
+  deadbandReset();
+
+  settings->acquisitionNbr = snapshot->measurementCount;
+  settings->averaging = snapshot->averaging;
+  *settings->blockSize = snapshot->blockSize;
+  settings->syncBytes[0] = (snapshot->blockSize & 0b1111111) | 0b10000000;
+  settings->syncBytes[1] = ((snapshot->blockSize >> 7) & 0b1111111) | 0b10000000;
+  settings->mode = snapshot->mode;
+  coreSelectDataCom();
+  settings->encoding = snapshot->encoding;
+  for(uint8_t ch = 0; ch < 4; ch++)
+  {
+    settings->sequence[ch] = snapshot->sequence[ch];
+    settings->ADCgain[ch] = snapshot->adcGain[ch];
+  }
+  adcSetChannels();
+  adcSetGain();
+  settings->ADClowRes = snapshot->adcLowRes;
+  adcSetRes();
+  settings->calibration = snapshot->calibration;
+  settings->asciiUnit = snapshot->asciiUnit;
+  settings->asciiSeparator = snapshot->asciiSeparator;
+  settings->csvIndex = snapshot->csvIndex;
+  settings->spectrumType = snapshot->spectrumType;
+  settings->fftPoints = snapshot->fftPoints;
+  settings->spectrumAverages = snapshot->spectrumAverages;
+  settings->histogramPeriod = snapshot->histogramPeriod;
+  settings->deadband = snapshot->deadband;
+  settings->heartbeat = snapshot->heartbeat;
+  settings->latency = snapshot->latency;
+  vendorSetLatency(settings->latency);
+  settings->blockLatency = snapshot->blockLatency;
+  settings->DacPeriod = snapshot->dacPeriod;
+  setDacPeriod();
+  settings->LutLength = snapshot->lutLength;
+  SetDacPdcLength();
+  settings->NumOfRepeats = snapshot->dacRepeats;
+  settings->CurrentRepeats = 0;
+  setDacTransferMode(snapshot->dacTransferMode);
+  return true;
+} /*** end of snapshotApply ***/
+
+
+/********************************** end of snapshot.c **********************************/
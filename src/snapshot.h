@@ -0,0 +1,73 @@
+/************************************************************************************//**
+* \file     snapshot.h
+* \brief    This module implements binary snapshot of DAQ settings.
+****************************************************************************************/
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Version of snapshot, changes when its layout changes */
+#define SNAPSHOT_VERSION    1
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Settings snapshot sent by read command and taken by apply command, little
+ *         endian. Values are the parameters of the commands which set them.
+ */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  uint8_t id[2];                     /* 'C', 'F'                                       */
+  uint8_t version;                   /* SNAPSHOT_VERSION                               */
+  uint8_t size;                      /* Bytes of whole snapshot                        */
+  uint32_t samplePeriod;             /* Sample period in us                            */
+  uint16_t measurementCount;         /* Number of consecutive acquisitions             */
+  uint16_t averaging;                /* Number of averages                             */
+  uint16_t blockSize;                /* Samples in block                               */
+  uint8_t mode;                      /* Output mode                                    */
+  uint8_t encoding;                  /* BIN sample encoding                            */
+  uint8_t sequence[4];               /* Channel sequence, 0 ends it                    */
+  uint8_t adcGain[4];                /* ADC gain of every channel                      */
+  uint8_t adcLowRes;                 /* ADC resolution, 12 bits = 0, 10 bits = 1       */
+  uint8_t calibration;               /* Sample correction, off = 0, on = 1             */
+  uint8_t asciiUnit;                 /* Text output unit                               */
+  uint8_t asciiSeparator;            /* Text output separator                          */
+  uint8_t csvIndex;                  /* CSV sample index column                        */
+  uint8_t spectrumType;              /* Spectrum output                                */
+  uint16_t fftPoints;                /* Number of FFT points in spectrum mode          */
+  uint16_t spectrumAverages;         /* Number of spectra averaged before sending      */
+  uint16_t histogramPeriod;          /* Blocks between histograms                      */
+  uint16_t deadband;                 /* Reported change in 12-bit codes                */
+  uint32_t heartbeat;                /* Seconds between reports of all channels        */
+  uint16_t latency;                  /* Time data waits to fill USB transfer, in ms    */
+  uint16_t blockLatency;             /* Time samples wait for block to complete, in ms */
+  uint16_t dacPeriod;                /* DAC period in us                               */
+  uint16_t lutLength;                /* Number of LUT values                           */
+  uint16_t dacRepeats;               /* Number of LUT repeats, 0 = continuous          */
+  uint8_t dacTransferMode;           /* DAC transfer mode, half word = 0, word = 1     */
+  uint8_t reserved;                  /* Always 0                                       */
+}snapshot_t;
+COMPILER_PACK_RESET()
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void snapshotGet(daq_settings_t *settings, snapshot_t *snapshot);
+bool snapshotApply(daq_settings_t *settings, snapshot_t *snapshot);
+
+
+#endif /* SNAPSHOT_H_ */
+/********************************** end of snapshot.h **********************************/
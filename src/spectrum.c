@@ -0,0 +1,194 @@
+/************************************************************************************//**
+* \file     spectrum.c
+* \brief    This module implements spectrum mode of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "spectrum.h"                /* Spectrum mode                                  */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Accumulated spectra of all channels, at start of workspace. */
+#define SPECTRUM_ACC        ((uint64_t *)coreGetWorkspace())
+/** \brief FFT working buffer, interleaved complex values. Holds output when ready. */
+#define SPECTRUM_FFT        ((int16_t *)(SPECTRUM_ACC + SPECTRUM_MAX_BINS))
+/** \brief Averaged magnitude spectrum, stored over FFT buffer. */
+#define SPECTRUM_MAGNITUDES ((uint16_t *)(SPECTRUM_ACC + SPECTRUM_MAX_BINS))
+/** \brief Averaged power spectrum, stored over FFT buffer. */
+#define SPECTRUM_POWERS     ((uint32_t *)(SPECTRUM_ACC + SPECTRUM_MAX_BINS))
+
+#if (SPECTRUM_MAX_BINS * 8 + DSP_FFT_MAX_POINTS * 4) > CORE_WORKSPACE_SIZE
+#error "Spectrum buffers do not fit to core workspace"
+#endif
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Number of spectra accumulated so far. */
+static uint16_t spectrumCount = 0;
+/** \brief Number of bytes of spectrum waiting to be sent. */
+static uint16_t spectrumLen = 0;
+/** \brief Indicates spectrum is waiting to be sent. */
+static volatile bool spectrumReady = false;
+/** \brief Sync bytes marking start of spectrum, 7 bits each are number of bins. */
+static uint8_t spectrumSync[2];
+
+
+/****************************************************************************************
+*                          S P E C T R U M   U T I L I T I E S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Discards accumulated spectra. Must be called when spectrum settings change.
+**
+****************************************************************************************/
+void spectrumReset(void)
+{
+  uint64_t *spectrumAcc = SPECTRUM_ACC;
+
+  for(uint16_t i = 0; i < SPECTRUM_MAX_BINS; i++)
+  {
+    spectrumAcc[i] = 0;
+  }
+  spectrumCount = 0;
+  spectrumReady = false;
+} /*** end of spectrumReset ***/
+
+/************************************************************************************//**
+** \brief     Calculates windowed FFT of every enabled channel in completed block and
+**            accumulates it. Once enough spectra were accumulated the averaged spectrum
+**            is prepared for sending.
+** \param     block Pointer to completed ADC block.
+** \param     settings Pointer to DAQ settings.
+** \return    True if new averaged spectrum is ready, false otherwise.
+**
+****************************************************************************************/
+bool spectrumProcess(uint16_t *block, daq_settings_t *settings)
+{
+  uint64_t *spectrumAcc = SPECTRUM_ACC;
+  int16_t *fftBuff = SPECTRUM_FFT;
+  uint16_t *magnitudes = SPECTRUM_MAGNITUDES;
+  uint32_t *powers = SPECTRUM_POWERS;
+  uint8_t chCount = coreGetChannelCount();
+  uint16_t points = settings->fftPoints;
+  uint16_t half = points / 2;
+  uint16_t perCh;
+  /* Differential measurement, mid code is 0 V. Scale it to q15. */
+  int16_t mid = settings->ADClowRes ? 512 : 2048;
+  int16_t gain = settings->ADClowRes ? 64 : 16;
+  int32_t re, im;
+  uint32_t val;
+
+  /* Previous spectrum not sent yet, skip this block. */
+  if(spectrumReady || !chCount || ((uint32_t)chCount * half > SPECTRUM_MAX_BINS))
+  {
+    return false;
+  }
+  perCh = *settings->blockSize / chCount;
+
+  for(uint8_t ch = 0; ch < chCount; ch++)
+  {
+    /* Copy channel samples to FFT buffer, zero pad if block is too short. */
+    for(uint16_t i = 0; i < points; i++)
+    {
+      if(i < perCh)
+      {
+        fftBuff[2*i] = ((int16_t)(block[i*chCount + ch] & 0x0FFF) - mid) * gain;
+      }
+      else
+      {
+        fftBuff[2*i] = 0;
+      }
+      fftBuff[2*i + 1] = 0;
+    }
+
+    dspHannQ15(fftBuff, points, 2);
+    dspFftQ15(fftBuff, points);
+
+    /* Accumulate positive frequency bins. */
+    for(uint16_t k = 0; k < half; k++)
+    {
+      re = fftBuff[2*k];
+      im = fftBuff[2*k + 1];
+      val = (uint32_t)(re*re) + (uint32_t)(im*im);
+      if(settings->spectrumType == SPECTRUM_MAGNITUDE)
+      {
+        val = dspSqrt32(val);
+      }
+      spectrumAcc[ch*half + k] += val;
+    }
+  }
+
+  /* Not enough spectra to average yet. */
+  if(++spectrumCount < settings->spectrumAverages)
+  {
+    return false;
+  }
+
+  /* Store averaged spectrum to FFT buffer, it is not needed until it is sent. */
+  for(uint16_t i = 0; i < chCount*half; i++)
+  {
+    val = (uint32_t)(spectrumAcc[i] / spectrumCount);
+    if(settings->spectrumType == SPECTRUM_MAGNITUDE)
+    {
+      magnitudes[i] = (uint16_t)val;
+    }
+    else
+    {
+      powers[i] = val;
+    }
+    spectrumAcc[i] = 0;
+  }
+  spectrumLen = chCount * half;
+  spectrumLen *= (settings->spectrumType == SPECTRUM_MAGNITUDE) ? 2 : 4;
+  spectrumCount = 0;
+
+  /* Create sync bytes for this number of bins. */
+  spectrumSync[0] = ( half       & 0b1111111) | 0b10000000;
+  spectrumSync[1] = ((half >> 7) & 0b1111111) | 0b10000000;
+  spectrumReady = true;
+
+  return true;
+} /*** end of spectrumProcess ***/
+
+/************************************************************************************//**
+** \brief     Checks if spectrum is waiting to be sent.
+** \return    True if spectrum is ready, false otherwise.
+**
+****************************************************************************************/
+bool spectrumIsReady(void)
+{
+  return spectrumReady;
+} /*** end of spectrumIsReady ***/
+
+/************************************************************************************//**
+** \brief     Queues ready spectrum after its sync bytes. Buffer is released for next
+**            one once it is sent.
+**
+****************************************************************************************/
+void spectrumSend(void)
+{
+  if(!txFrame(spectrumSync, 2, (uint8_t *)SPECTRUM_FFT, spectrumLen, spectrumSent))
+  {
+    spectrumReady = false;
+  }
+} /*** end of spectrumSend ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when spectrum was sent.
+** \param     buf Start of the frame.
+** \param     len Number of sent bytes.
+**
+****************************************************************************************/
+void spectrumSent(uint8_t *buf, uint32_t len)
+{
+  spectrumReady = false;
+} /*** end of spectrumSent ***/
+
+
+/********************************** end of spectrum.c **********************************/
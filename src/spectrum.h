@@ -0,0 +1,42 @@
+/************************************************************************************//**
+* \file     spectrum.h
+* \brief    This module implements spectrum mode of the DAQ.
+****************************************************************************************/
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "core.h"                    /* Core functionality for acquisition             */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "dsp.h"                     /* Fixed-point signal processing kernels          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Spectrum output types */
+/** \brief Spectrum bins are magnitudes, 16-bit each */
+#define SPECTRUM_MAGNITUDE  0
+/** \brief Spectrum bins are powers, 32-bit each */
+#define SPECTRUM_POWER      1
+
+/** \brief Maximum number of bins of all channels together */
+#define SPECTRUM_MAX_BINS   (ADC_BUFFER_SIZE * 4 / 2)
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void spectrumReset(void);
+bool spectrumProcess(uint16_t *block, daq_settings_t *settings);
+bool spectrumIsReady(void);
+void spectrumSend(void);
+void spectrumSent(uint8_t *buf, uint32_t len);
+
+
+#endif /* SPECTRUM_H_ */
+/********************************** end of spectrum.h **********************************/
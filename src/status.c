@@ -0,0 +1,166 @@
+/************************************************************************************//**
+* \file     status.c
+* \brief    This module implements health and throughput counters of the DAQ. Modules
+*           count events where they happen, status command reads all counters at once
+*           while acquisition keeps running.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "status.h"                  /* Health and throughput counters                 */
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Counters and maximums. */
+static volatile uint32_t statusCounters[STATUS_COUNTERS];
+/** \brief Milliseconds counted by USB start of frame. */
+static volatile uint32_t statusUptime = 0;
+/** \brief Bytes sent counter at the start of throughput period. */
+static uint32_t statusRateStart = 0;
+/** \brief Bytes sent per second in the last period. */
+static volatile uint32_t statusRate = 0;
+/** \brief Most bytes sent per second since boot. */
+static volatile uint32_t statusRatePeak = 0;
+
+
+/****************************************************************************************
+*                                      S T A T U S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Increments counter.
+** \param     counter Counter index.
+**
+****************************************************************************************/
+void statusCount(uint8_t counter)
+{
+  statusCounters[counter]++;
+} /*** end of statusCount ***/
+
+/************************************************************************************//**
+** \brief     Adds value to counter.
+** \param     counter Counter index.
+** \param     value Added value.
+**
+****************************************************************************************/
+void statusAdd(uint8_t counter, uint32_t value)
+{
+  statusCounters[counter] += value;
+} /*** end of statusAdd ***/
+
+/************************************************************************************//**
+** \brief     Keeps the largest value seen.
+** \param     counter Counter index of a maximum.
+** \param     value Current value.
+**
+****************************************************************************************/
+void statusMax(uint8_t counter, uint32_t value)
+{
+  if(value > statusCounters[counter])
+  {
+    statusCounters[counter] = value;
+  }
+} /*** end of statusMax ***/
+
+/************************************************************************************//**
+** \brief     Keeps the smallest value seen. Counter holds value plus 1, so a cleared
+**            counter means nothing was measured and reads as 0xFFFFFFFF.
+** \param     counter Counter index of a minimum.
+** \param     value Current value, less than 0xFFFFFFFF.
+**
+****************************************************************************************/
+void statusMin(uint8_t counter, uint32_t value)
+{
+  if(!statusCounters[counter] || (value + 1 < statusCounters[counter]))
+  {
+    statusCounters[counter] = value + 1;
+  }
+} /*** end of statusMin ***/
+
+/************************************************************************************//**
+** \brief     Counts time, called by USB start of frame every 1 ms. Throughput of
+**            the interfaces is measured from bytes sent counter once per period.
+**
+****************************************************************************************/
+void statusTick(void)
+{
+  uint32_t sent;
+
+  statusUptime++;
+  if(statusUptime % STATUS_RATE_PERIOD)
+  {
+    return;
+  }
+  sent = statusCounters[STATUS_BYTES_SENT];
+  statusRate = (sent - statusRateStart) * (1000 / STATUS_RATE_PERIOD);
+  statusRateStart = sent;
+  if(statusRate > statusRatePeak)
+  {
+    statusRatePeak = statusRate;
+  }
+} /*** end of statusTick ***/
+
+/************************************************************************************//**
+** \brief     Fills status record. Counters are copied with interrupts disabled, so they
+**            are consistent with each other.
+** \param     record Record to fill.
+** \param     clear Counters, maximums and minimums start again after they are copied.
+**
+****************************************************************************************/
+void statusGetRecord(status_record_t *record, bool clear)
+{
+  irqflags_t flags = cpu_irq_save();
+
+  record->id[0] = 'S';
+  record->id[1] = 'T';
+  record->version = STATUS_VERSION;
+  record->size = sizeof(status_record_t);
+  record->uptime = statusUptime;
+  for(uint8_t i = 0; i < STATUS_COUNTERS; i++)
+  {
+    record->counters[i] = statusCounters[i];
+    if((i == STATUS_CONTROL_FREE_MIN) || (i == STATUS_DATA_FREE_MIN))
+    {
+      /* Minimums are stored plus 1. */
+      record->counters[i]--;
+    }
+    if(clear)
+    {
+      statusCounters[i] = 0;
+    }
+  }
+  if(clear)
+  {
+    /* Period in progress counts from here. */
+    statusRateStart = 0;
+  }
+  cpu_irq_restore(flags);
+} /*** end of statusGetRecord ***/
+
+/************************************************************************************//**
+** \brief     Gets throughput of the interfaces, bytes written or submitted to them.
+** \param     rate Bytes per second in the last period, 0 before the first one ended.
+** \param     peak Most bytes per second since boot.
+**
+****************************************************************************************/
+void statusGetRate(uint32_t *rate, uint32_t *peak)
+{
+  *rate = statusRate;
+  *peak = statusRatePeak;
+} /*** end of statusGetRate ***/
+
+/************************************************************************************//**
+** \brief     Gets time since boot.
+** \return    Milliseconds counted by USB start of frame, wraps around.
+**
+****************************************************************************************/
+uint32_t statusGetUptime(void)
+{
+  return statusUptime;
+} /*** end of statusGetUptime ***/
+
+
+/*********************************** end of status.c ***********************************/
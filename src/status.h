@@ -0,0 +1,89 @@
+/************************************************************************************//**
+* \file     status.h
+* \brief    This module implements health and throughput counters of the DAQ.
+****************************************************************************************/
+#ifndef STATUS_H_
+#define STATUS_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Version of status record, changes when its layout changes */
+#define STATUS_VERSION      1
+
+/* Counters, each is written from one priority only or with interrupts disabled */
+/** \brief ADC conversions overwritten before PDC read them */
+#define STATUS_ADC_OVERRUNS 0
+/** \brief Blocks PDC completed without next block, samples were lost after them */
+#define STATUS_BLOCKS_LOST  1
+/** \brief Completed blocks dropped because PDC was restarted */
+#define STATUS_BLOCKS_STALE 2
+/** \brief Acquisition stopped because blocks were not sent in time */
+#define STATUS_ACQ_STOPS    3
+/** \brief Data frames which did not fit to transmit queue or were dropped from it */
+#define STATUS_FRAMES_DROPPED 4
+/** \brief Transfers of vendor interface aborted by USB stack */
+#define STATUS_TX_ABORTS    5
+/** \brief Bytes written to interfaces, wraps around */
+#define STATUS_BYTES_SENT   6
+/** \brief Commands executed */
+#define STATUS_COMMANDS     7
+/** \brief Commands with wrong syntax */
+#define STATUS_PARSE_ERRORS 8
+/** \brief Commands rejected by their handler */
+#define STATUS_COMMAND_ERRORS 9
+/** \brief Most samples PDC stored in a block before it got the next one */
+#define STATUS_REARM_MAX    10
+/** \brief Most data frames waiting in transmit queue */
+#define STATUS_TX_QUEUE_MAX 11
+/** \brief Most bytes waiting in command reply buffer */
+#define STATUS_REPLY_MAX    12
+/** \brief Least free bytes of control interface transmit buffer, see statusMin */
+#define STATUS_CONTROL_FREE_MIN 13
+/** \brief Least free bytes of data interface transmit buffer, see statusMin */
+#define STATUS_DATA_FREE_MIN 14
+/** \brief Number of counters */
+#define STATUS_COUNTERS     15
+
+/** \brief Milliseconds over which throughput is measured */
+#define STATUS_RATE_PERIOD  1000
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Status record sent by status command, little endian */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  uint8_t id[2];                     /* 'S', 'T'                                       */
+  uint8_t version;                   /* STATUS_VERSION                                 */
+  uint8_t size;                      /* Bytes of whole record                          */
+  uint32_t uptime;                   /* Milliseconds counted by USB start of frame     */
+  uint32_t counters[STATUS_COUNTERS];/* Counters in order of their index               */
+}status_record_t;
+COMPILER_PACK_RESET()
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void statusCount(uint8_t counter);
+void statusAdd(uint8_t counter, uint32_t value);
+void statusMax(uint8_t counter, uint32_t value);
+void statusMin(uint8_t counter, uint32_t value);
+void statusTick(void);
+void statusGetRecord(status_record_t *record, bool clear);
+void statusGetRate(uint32_t *rate, uint32_t *peak);
+uint32_t statusGetUptime(void);
+
+
+#endif /* STATUS_H_ */
+/*********************************** end of status.h ***********************************/
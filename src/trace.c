@@ -0,0 +1,130 @@
+/************************************************************************************//**
+* \file     trace.c
+* \brief    This module implements event trace of the DAQ. Interrupts and event
+*           handlers record events with cycle counter time to a circular buffer in
+*           SRAM. The buffer is dumped as one data frame and decoded on the host
+*           (host/trace_decode.c), so interplay of interrupts and USB can be seen on a
+*           timeline.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "trace.h"                   /* Event trace                                    */
+#include "tx.h"                      /* Transmit arbiter                               */
+
+#ifdef TRACE
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void traceSent(uint8_t *buf, uint32_t len);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Recorded events, written in turns. */
+static trace_entry_t traceEntries[TRACE_SIZE];
+/** \brief Header of dump being sent. */
+static trace_header_t traceHeader;
+/** \brief Events recorded since trace was cleared, next entry is at its low bits. */
+static uint32_t traceCount = 0;
+/** \brief Indicates dump is being sent, events are not recorded meanwhile. */
+static volatile bool traceFrozen = false;
+/** \brief Indicates trace is cleared once dump is sent. */
+static bool traceClear = false;
+
+
+/****************************************************************************************
+*                                       T R A C E
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Enables DWT cycle counter, which gives time of events.
+**
+****************************************************************************************/
+void traceInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+} /*** end of traceInit ***/
+
+/************************************************************************************//**
+** \brief     Records event. Called from every priority, so interrupts are disabled for
+**            the few instructions it takes.
+** \param     event Event type.
+** \param     par Parameter of event.
+**
+****************************************************************************************/
+void traceRecord(uint8_t event, uint16_t par)
+{
+  irqflags_t flags = cpu_irq_save();
+  trace_entry_t *entry;
+
+  if(!traceFrozen)
+  {
+    entry = &traceEntries[traceCount & (TRACE_SIZE - 1)];
+    entry->time = DWT->CYCCNT;
+    entry->event = event;
+    entry->reserved = 0;
+    entry->par = par;
+    traceCount++;
+  }
+  cpu_irq_restore(flags);
+} /*** end of traceRecord ***/
+
+/************************************************************************************//**
+** \brief     Sends trace as data frame: trace_header_t, then all entries as they are
+**            stored. Entries are sent by reference, so recording stops until the frame
+**            was sent.
+** \param     clear Trace starts empty after it was sent.
+** \return    True if successful, false if previous dump is still being sent or frame
+**            queue is full.
+**
+****************************************************************************************/
+bool traceDump(bool clear)
+{
+  if(traceFrozen)
+  {
+    return false;
+  }
+  traceFrozen = true;
+  traceClear = clear;
+  traceHeader.id[0] = 'T';
+  traceHeader.id[1] = 'R';
+  traceHeader.version = TRACE_VERSION;
+  traceHeader.entrySize = sizeof(trace_entry_t);
+  traceHeader.entries = TRACE_SIZE;
+  traceHeader.next = traceCount & (TRACE_SIZE - 1);
+  traceHeader.count = traceCount;
+  traceHeader.cpuHz = sysclk_get_cpu_hz();
+  if(!txFrame((uint8_t *)&traceHeader, sizeof(traceHeader), (uint8_t *)traceEntries,
+              sizeof(traceEntries), traceSent))
+  {
+    traceFrozen = false;
+    return false;
+  }
+  return true;
+} /*** end of traceDump ***/
+
+/************************************************************************************//**
+** \brief     Called by transmit arbiter when dump was sent or dropped, recording
+**            continues.
+** \param     buf Dump header.
+** \param     len Number of bytes of dump.
+**
+****************************************************************************************/
+void traceSent(uint8_t *buf, uint32_t len)
+{
+  if(traceClear)
+  {
+    traceCount = 0;
+  }
+  traceFrozen = false;
+} /*** end of traceSent ***/
+
+#endif /* TRACE */
+
+
+/************************************ end of trace.c ***********************************/
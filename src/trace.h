@@ -0,0 +1,96 @@
+/************************************************************************************//**
+* \file     trace.h
+* \brief    This module implements event trace of the DAQ. It is built only if TRACE is
+*           defined (Debug configuration), otherwise every macro is empty and nothing is
+*           compiled in.
+****************************************************************************************/
+#ifndef TRACE_H_
+#define TRACE_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Version of trace dump, changes when its layout changes */
+#define TRACE_VERSION       1
+/** \brief Number of entries kept, older ones are overwritten, power of 2 */
+#define TRACE_SIZE          128
+
+/* Traced events */
+/** \brief ADC block completed by PDC, parameter is block index */
+#define TRACE_ADC_BLOCK     0
+/** \brief Next block given to PDC, parameter is block index */
+#define TRACE_ADC_REARM     1
+/** \brief Processing of completed block started, parameter is block index */
+#define TRACE_BLOCK_START   2
+/** \brief Processing of completed block ended, parameter is block index */
+#define TRACE_BLOCK_END     3
+/** \brief Part of block sent before it completed, parameter is number of samples */
+#define TRACE_FLUSH         4
+/** \brief Bytes written or submitted to interface, parameter is number of bytes */
+#define TRACE_TX_SUBMIT     5
+/** \brief Interface has room for more data */
+#define TRACE_TX_DONE       6
+/** \brief Command bytes received */
+#define TRACE_USB_RX        7
+/** \brief Command parsed, parameter is command character */
+#define TRACE_COMMAND       8
+/** \brief DAC LUT transfer ended, parameter is number of repeats done */
+#define TRACE_DAC_REPEAT    9
+
+#ifdef TRACE
+/** \brief Enables cycle counter */
+#define TRACE_INIT()        traceInit()
+/** \brief Records event with cycle counter time */
+#define TRACE_EVENT(event, par) traceRecord((event), (uint16_t)(par))
+#else
+#define TRACE_INIT()
+#define TRACE_EVENT(event, par)
+#endif
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Header of trace dump, entries follow in the order they are stored */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  uint8_t id[2];                     /* 'T', 'R'                                       */
+  uint8_t version;                   /* TRACE_VERSION                                  */
+  uint8_t entrySize;                 /* Bytes of one entry                             */
+  uint16_t entries;                  /* TRACE_SIZE                                     */
+  uint16_t next;                     /* Entry written next, the oldest one if wrapped  */
+  uint32_t count;                    /* Events recorded since trace was cleared        */
+  uint32_t cpuHz;                    /* Frequency of cycle counter                     */
+}trace_header_t;
+
+/** \brief Traced event */
+typedef struct
+{
+  uint32_t time;                     /* Cycle counter                                  */
+  uint8_t event;                     /* Event type                                     */
+  uint8_t reserved;                  /* Always 0                                       */
+  uint16_t par;                      /* Parameter of event                             */
+}trace_entry_t;
+COMPILER_PACK_RESET()
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+#ifdef TRACE
+void traceInit(void);
+void traceRecord(uint8_t event, uint16_t par);
+bool traceDump(bool clear);
+#endif
+
+
+#endif /* TRACE_H_ */
+/************************************ end of trace.h ***********************************/
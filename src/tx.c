@@ -0,0 +1,453 @@
+/************************************************************************************//**
+* \file     tx.c
+* \brief    This module implements transmit arbiter of the DAQ.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "tx.h"                      /* Transmit arbiter                               */
+#include "event.h"                   /* Event queues                                   */
+#include "profile.h"                 /* Cycle counter profiling                        */
+#include "status.h"                  /* Health and throughput counters                 */
+#include "trace.h"                   /* Event trace                                    */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Item being written to the interface */
+/** \brief Nothing is being written */
+#define TX_IDLE             0
+/** \brief Data frame at head of frame queue is being written */
+#define TX_DATA             1
+/** \brief Command replies are being written */
+#define TX_CONTROL          2
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Data frame, header and payload are sent from producer buffers */
+typedef struct
+{
+  uint8_t *buf[2];                   /* Header and payload                             */
+  uint32_t len[2];                   /* Number of bytes of header and payload          */
+  tx_done_t done;                    /* Called when frame is sent, may be NULL         */
+  bool block;                        /* Header is in buffer, sent without copying      */
+}tx_frame_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+bool txQueue(uint8_t *header, uint32_t headerLen, uint8_t *payload, uint32_t payloadLen,
+             tx_done_t done, bool block);
+uint32_t txWriteControl(uint32_t room);
+uint32_t txWriteData(uint32_t room);
+void txFrameSent(void);
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Interface data frames are written to. */
+static COM_t *txDataCom = NULL;
+/** \brief Interface command replies are written to, may be the same as data one. */
+static COM_t *txControlCom = NULL;
+/** \brief Queue of data frames. */
+static tx_frame_t txFrames[TX_FRAMES];
+/** \brief Total number of frames queued. */
+static volatile uint32_t txFrameTail = 0;
+/** \brief Total number of frames sent, queue is full when TX_FRAMES behind tail. */
+static volatile uint32_t txFrameHead = 0;
+/** \brief Part of frame being written, 0 is header and 1 is payload. */
+static uint8_t txPart = 0;
+/** \brief Number of bytes of the part already written. */
+static uint32_t txOffset = 0;
+/** \brief Command replies waiting to be sent. */
+static uint8_t txControl[TX_CONTROL_SIZE];
+/** \brief Total number of bytes written to reply buffer. */
+static volatile uint32_t txControlTail = 0;
+/** \brief Total number of bytes sent from reply buffer. */
+static volatile uint32_t txControlHead = 0;
+/** \brief Item being written to the interface. */
+static uint8_t txState = TX_IDLE;
+/** \brief Indicates arbiter is running, frames queued by done callbacks wait. */
+static bool txPumping = false;
+
+
+/****************************************************************************************
+*                              T R A N S M I T   A R B I T E R
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Links arbiter to the interfaces. Everything written to the interfaces has
+**            to go through the arbiter from now on. On separate interfaces replies are
+**            never held behind data, on a shared one replies and frames do not get
+**            mixed.
+** \param     data Pointer to the communication interface of data frames.
+** \param     control Pointer to the communication interface of command replies.
+**
+****************************************************************************************/
+void txInit(COM_t *data, COM_t *control)
+{
+  txDataCom = data;
+  txControlCom = control;
+} /*** end of txInit ***/
+
+/************************************************************************************//**
+** \brief     Changes interface of data frames. Called after txDropFrames, so no frame
+**            is split between the interfaces.
+** \param     data Pointer to the communication interface of data frames.
+**
+****************************************************************************************/
+void txSetDataCom(COM_t *data)
+{
+  uint32_t flags = eventLock();
+
+  txDataCom = data;
+  eventUnlock(flags);
+} /*** end of txSetDataCom ***/
+
+/************************************************************************************//**
+** \brief     Queues data frame, header is sent right before payload. Buffers are not
+**            copied, they must stay unchanged until done callback is called. Frame is
+**            never interrupted by a command reply. Called from event handlers, never
+**            from interrupts above USB priority.
+** \param     header Frame header, may be NULL if headerLen is 0.
+** \param     headerLen Number of bytes of header.
+** \param     payload Frame payload, may be NULL if payloadLen is 0.
+** \param     payloadLen Number of bytes of payload.
+** \param     done Called with header and frame length when frame is sent or dropped,
+**            may be NULL.
+** \return    True if successful, false if frame queue is full.
+**
+****************************************************************************************/
+bool txFrame(uint8_t *header, uint32_t headerLen, uint8_t *payload, uint32_t payloadLen,
+             tx_done_t done)
+{
+  if(!txQueue(header, headerLen, payload, payloadLen, done, false))
+  {
+    return false;
+  }
+  txPump();
+  return true;
+} /*** end of txFrame ***/
+
+/************************************************************************************//**
+** \brief     Queues data frame which is already whole in one buffer, header included.
+**            Interface which can send a buffer by reference gets it as is and calls
+**            done callback once it was sent, others get it copied like any frame.
+**            Buffer must stay unchanged until done callback is called.
+** \param     frame Whole frame.
+** \param     len Number of bytes of frame.
+** \param     done Called with frame and its length when frame is sent or dropped, may
+**            be NULL.
+** \return    True if successful, false if frame queue is full.
+**
+****************************************************************************************/
+bool txBlock(uint8_t *frame, uint32_t len, tx_done_t done)
+{
+  if(!txQueue(frame, len, NULL, 0, done, true))
+  {
+    return false;
+  }
+  txPump();
+  return true;
+} /*** end of txBlock ***/
+
+/************************************************************************************//**
+** \brief     Queues command reply, text is copied. Replies are sent before waiting data
+**            frames, but never inside a frame being sent.
+** \param     text Reply text.
+** \param     len Length of text.
+** \return    True if successful, false if reply buffer is full.
+**
+****************************************************************************************/
+bool txReply(uint8_t *text, uint16_t len)
+{
+  uint32_t flags = eventLock();
+
+  if(len > TX_CONTROL_SIZE - (txControlTail - txControlHead))
+  {
+    eventUnlock(flags);
+    return false;
+  }
+  for(uint16_t i = 0; i < len; i++)
+  {
+    txControl[(txControlTail + i) & (TX_CONTROL_SIZE - 1)] = text[i];
+  }
+  txControlTail += len;
+  statusMax(STATUS_REPLY_MAX, txControlTail - txControlHead);
+  eventUnlock(flags);
+
+  txPump();
+  return true;
+} /*** end of txReply ***/
+
+/************************************************************************************//**
+** \brief     Writes as much as fits to the interfaces without waiting. Replies and
+**            frames are sent in order. On a shared interface item being sent is always
+**            finished first, then command replies go before data frames. Called after
+**            queuing and from transmit empty event of both interfaces.
+**
+****************************************************************************************/
+void txPump(void)
+{
+  uint32_t flags;
+  uint32_t room;
+
+  if((txDataCom == NULL) || (txControlCom == NULL))
+  {
+    return;
+  }
+  flags = eventLock();
+  if(txPumping)
+  {
+    eventUnlock(flags);
+    return;
+  }
+  txPumping = true;
+  PROFILE_START();
+
+  if(txControlCom != txDataCom)
+  {
+    /* Replies never wait for data on their own interface. */
+    room = txControlCom->txFree();
+    statusMin(STATUS_CONTROL_FREE_MIN, room);
+    while(room && (txControlTail != txControlHead))
+    {
+      room -= txWriteControl(room);
+    }
+    room = txDataCom->txFree();
+    statusMin(STATUS_DATA_FREE_MIN, room);
+    while(room && (txFrameTail != txFrameHead))
+    {
+      if(txState == TX_IDLE)
+      {
+        txState = TX_DATA;
+        txPart = 0;
+        txOffset = 0;
+      }
+      room -= txWriteData(room);
+    }
+    txPumping = false;
+    eventUnlock(flags);
+    PROFILE_STOP(PROFILE_TX_PUMP);
+    return;
+  }
+
+  room = txDataCom->txFree();
+  /* Replies and data share the interface. */
+  statusMin(STATUS_CONTROL_FREE_MIN, room);
+  statusMin(STATUS_DATA_FREE_MIN, room);
+  while(room)
+  {
+    if(txState == TX_IDLE)
+    {
+      if(txControlTail != txControlHead)
+      {
+        txState = TX_CONTROL;
+      }
+      else if(txFrameTail != txFrameHead)
+      {
+        txState = TX_DATA;
+        txPart = 0;
+        txOffset = 0;
+      }
+      else
+      {
+        break;
+      }
+    }
+    if(txState == TX_CONTROL)
+    {
+      room -= txWriteControl(room);
+      if(txControlHead == txControlTail)
+      {
+        txState = TX_IDLE;
+      }
+    }
+    else
+    {
+      room -= txWriteData(room);
+    }
+  }
+
+  txPumping = false;
+  eventUnlock(flags);
+  PROFILE_STOP(PROFILE_TX_PUMP);
+} /*** end of txPump ***/
+
+/************************************************************************************//**
+** \brief     Drops data frames which were not sent yet, their done callbacks are called
+**            right away. Frame being written is cut short, none of its bytes are read
+**            after its callback. Frames given to the interface by reference are
+**            released by the interface. Must be called before producer buffers are
+**            reset.
+**
+****************************************************************************************/
+void txDropFrames(void)
+{
+  uint32_t flags = eventLock();
+  tx_frame_t *frame;
+
+  txPumping = true;
+  for(uint32_t i = txFrameHead; i != txFrameTail; i++)
+  {
+    frame = &txFrames[i % TX_FRAMES];
+    if(frame->done != NULL)
+    {
+      frame->done(frame->buf[0], frame->len[0] + frame->len[1]);
+    }
+  }
+  statusAdd(STATUS_FRAMES_DROPPED, txFrameTail - txFrameHead);
+  txFrameTail = txFrameHead;
+  if(txState == TX_DATA)
+  {
+    txState = TX_IDLE;
+  }
+  txPumping = false;
+  eventUnlock(flags);
+} /*** end of txDropFrames ***/
+
+/************************************************************************************//**
+** \brief     Adds data frame to frame queue.
+** \param     header Frame header, may be NULL if headerLen is 0.
+** \param     headerLen Number of bytes of header.
+** \param     payload Frame payload, may be NULL if payloadLen is 0.
+** \param     payloadLen Number of bytes of payload.
+** \param     done Called with header and frame length when frame is sent or dropped,
+**            may be NULL.
+** \param     block True if frame may be given to the interface by reference.
+** \return    True if successful, false if frame queue is full.
+**
+****************************************************************************************/
+bool txQueue(uint8_t *header, uint32_t headerLen, uint8_t *payload, uint32_t payloadLen,
+             tx_done_t done, bool block)
+{
+  uint32_t flags = eventLock();
+  tx_frame_t *frame;
+
+  if(txFrameTail - txFrameHead >= TX_FRAMES)
+  {
+    eventUnlock(flags);
+    statusCount(STATUS_FRAMES_DROPPED);
+    return false;
+  }
+  frame = &txFrames[txFrameTail % TX_FRAMES];
+  frame->buf[0] = header;
+  frame->len[0] = headerLen;
+  frame->buf[1] = payload;
+  frame->len[1] = payloadLen;
+  frame->done = done;
+  frame->block = block;
+  txFrameTail++;
+  statusMax(STATUS_TX_QUEUE_MAX, txFrameTail - txFrameHead);
+  eventUnlock(flags);
+  return true;
+} /*** end of txQueue ***/
+
+/************************************************************************************//**
+** \brief     Writes command replies, in two parts if they wrap around the end of the
+**            reply buffer.
+** \param     room Number of bytes which fit to the interface.
+** \return    Number of written bytes.
+**
+****************************************************************************************/
+uint32_t txWriteControl(uint32_t room)
+{
+  uint32_t start = txControlHead & (TX_CONTROL_SIZE - 1);
+  uint32_t len = txControlTail - txControlHead;
+
+  if(len > TX_CONTROL_SIZE - start)
+  {
+    len = TX_CONTROL_SIZE - start;
+  }
+  if(len > room)
+  {
+    len = room;
+  }
+  txControlCom->printBuf(&txControl[start], (uint16_t)len);
+  txControlHead += len;
+  statusAdd(STATUS_BYTES_SENT, len);
+  TRACE_EVENT(TRACE_TX_SUBMIT, len);
+  return len;
+} /*** end of txWriteControl ***/
+
+/************************************************************************************//**
+** \brief     Writes next part of data frame at head of frame queue.
+** \param     room Number of bytes which fit to the interface.
+** \return    Number of written bytes.
+**
+****************************************************************************************/
+uint32_t txWriteData(uint32_t room)
+{
+  tx_frame_t *frame = &txFrames[txFrameHead % TX_FRAMES];
+  uint32_t len = 0;
+
+  /* Whole frame is handed over, interface calls done callback when it is sent. */
+  if(frame->block && (txDataCom->submit != NULL) && !txPart && !txOffset)
+  {
+    if(!txDataCom->submit(frame->buf[0], (uint16_t)frame->len[0], frame->done))
+    {
+      /* Interface is busy, its transmit empty callback pumps again. */
+      txState = TX_IDLE;
+      return room;
+    }
+    statusAdd(STATUS_BYTES_SENT, frame->len[0]);
+    TRACE_EVENT(TRACE_TX_SUBMIT, frame->len[0]);
+    txFrameHead++;
+    txState = TX_IDLE;
+    return 0;
+  }
+  if(txPart < 2)
+  {
+    len = frame->len[txPart] - txOffset;
+    if(len > room)
+    {
+      len = room;
+    }
+    if(len)
+    {
+      txDataCom->printBuf(&frame->buf[txPart][txOffset], (uint16_t)len);
+      statusAdd(STATUS_BYTES_SENT, len);
+      TRACE_EVENT(TRACE_TX_SUBMIT, len);
+    }
+    txOffset += len;
+  }
+  /* Skip finished and empty parts. */
+  while((txPart < 2) && (txOffset >= frame->len[txPart]))
+  {
+    txPart++;
+    txOffset = 0;
+  }
+  if(txPart >= 2)
+  {
+    txFrameSent();
+  }
+  return len;
+} /*** end of txWriteData ***/
+
+/************************************************************************************//**
+** \brief     Removes sent frame from frame queue and releases its buffers.
+**
+****************************************************************************************/
+void txFrameSent(void)
+{
+  tx_frame_t *frame = &txFrames[txFrameHead % TX_FRAMES];
+  tx_done_t done = frame->done;
+  uint8_t *buf = frame->buf[0];
+  uint32_t len = frame->len[0] + frame->len[1];
+
+  txFrameHead++;
+  txState = TX_IDLE;
+  if(done != NULL)
+  {
+    done(buf, len);
+  }
+} /*** end of txFrameSent ***/
+
+
+/************************************* end of tx.c *************************************/
@@ -0,0 +1,48 @@
+/************************************************************************************//**
+* \file     tx.h
+* \brief    This module implements transmit arbiter of the DAQ.
+****************************************************************************************/
+#ifndef TX_H_
+#define TX_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "comInterface.h"            /* USB interface driver                           */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of data frames waiting to be sent */
+#define TX_FRAMES           8
+/** \brief Size of command reply buffer, power of 2 */
+#define TX_CONTROL_SIZE     512
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Called with first buffer of a data frame when its last byte was written, or
+ *         the frame was dropped. Buffers of the frame may be reused after it is called.
+ */
+typedef void (*tx_done_t)(uint8_t *buf, uint32_t len);
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void txInit(COM_t *data, COM_t *control);
+void txSetDataCom(COM_t *data);
+bool txFrame(uint8_t *header, uint32_t headerLen, uint8_t *payload, uint32_t payloadLen,
+             tx_done_t done);
+bool txBlock(uint8_t *frame, uint32_t len, tx_done_t done);
+bool txReply(uint8_t *text, uint16_t len);
+void txPump(void);
+void txDropFrames(void);
+
+
+#endif /* TX_H_ */
+/************************************* end of tx.h *************************************/
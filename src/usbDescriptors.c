@@ -0,0 +1,178 @@
+/************************************************************************************//**
+* \file     usbDescriptors.c
+* \brief    This module implements USB descriptors of the DAQ. Device is composite, CDC
+*           port 0 carries commands and replies, CDC port 1 text data and vendor bulk
+*           interface binary data. Replaces udi_cdc_desc.c of ASF, which describes CDC
+*           ports only.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "conf_usb.h"                /* USB configuration                              */
+#include "udd.h"                     /* USB device driver                              */
+#include "udc_desc.h"                /* USB device descriptor types                    */
+#include "udi_cdc.h"                 /* USB CDC interface                              */
+#include "vendor.h"                  /* Vendor bulk streaming interface                */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/* Device class of a composite device with interface association descriptors */
+/** \brief Miscellaneous device class */
+#define USB_DESC_CLASS_MISC     0xEF
+/** \brief Common class subclass */
+#define USB_DESC_SUBCLASS_COMMON 0x02
+/** \brief Interface association descriptor protocol */
+#define USB_DESC_PROTOCOL_IAD   0x01
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Configuration descriptor with all interfaces */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  usb_conf_desc_t conf;              /* Configuration descriptor                       */
+  usb_iad_desc_t cdcIad0;            /* Control port interface association             */
+  udi_cdc_comm_desc_t cdcComm0;      /* Control port communication interface           */
+  udi_cdc_data_desc_t cdcData0;      /* Control port data interface                    */
+  usb_iad_desc_t cdcIad1;            /* Text port interface association                */
+  udi_cdc_comm_desc_t cdcComm1;      /* Text port communication interface              */
+  udi_cdc_data_desc_t cdcData1;      /* Text port data interface                       */
+  udi_vendor_desc_t vendor;          /* Vendor bulk interface                          */
+}udc_desc_t;
+COMPILER_PACK_RESET()
+
+
+/****************************************************************************************
+* Global data declarations
+****************************************************************************************/
+/** \brief USB device descriptor */
+COMPILER_WORD_ALIGNED
+UDC_DESC_STORAGE usb_dev_desc_t udc_device_desc =
+{
+  .bLength                   = sizeof(usb_dev_desc_t),
+  .bDescriptorType           = USB_DT_DEVICE,
+  .bcdUSB                    = LE16(USB_V2_0),
+  .bDeviceClass              = USB_DESC_CLASS_MISC,
+  .bDeviceSubClass           = USB_DESC_SUBCLASS_COMMON,
+  .bDeviceProtocol           = USB_DESC_PROTOCOL_IAD,
+  .bMaxPacketSize0           = USB_DEVICE_EP_CTRL_SIZE,
+  .idVendor                  = LE16(USB_DEVICE_VENDOR_ID),
+  .idProduct                 = LE16(USB_DEVICE_PRODUCT_ID),
+  .bcdDevice                 = LE16((USB_DEVICE_MAJOR_VERSION << 8)
+                                    | USB_DEVICE_MINOR_VERSION),
+  .iManufacturer             = 0,
+  .iProduct                  = 0,
+  .iSerialNumber             = 0,
+  .bNumConfigurations        = 1
+};
+
+#ifdef USB_DEVICE_HS_SUPPORT
+/** \brief USB device qualifier descriptor */
+COMPILER_WORD_ALIGNED
+UDC_DESC_STORAGE usb_dev_qual_desc_t udc_device_qual =
+{
+  .bLength                   = sizeof(usb_dev_qual_desc_t),
+  .bDescriptorType           = USB_DT_DEVICE_QUALIFIER,
+  .bcdUSB                    = LE16(USB_V2_0),
+  .bDeviceClass              = USB_DESC_CLASS_MISC,
+  .bDeviceSubClass           = USB_DESC_SUBCLASS_COMMON,
+  .bDeviceProtocol           = USB_DESC_PROTOCOL_IAD,
+  .bMaxPacketSize0           = USB_DEVICE_EP_CTRL_SIZE,
+  .bNumConfigurations        = 1
+};
+#endif
+
+/** \brief USB configuration descriptor for full speed */
+COMPILER_WORD_ALIGNED
+UDC_DESC_STORAGE udc_desc_t udc_desc_fs =
+{
+  .conf.bLength              = sizeof(usb_conf_desc_t),
+  .conf.bDescriptorType      = USB_DT_CONFIGURATION,
+  .conf.wTotalLength         = LE16(sizeof(udc_desc_t)),
+  .conf.bNumInterfaces       = USB_DEVICE_NB_INTERFACE,
+  .conf.bConfigurationValue  = 1,
+  .conf.iConfiguration       = 0,
+  .conf.bmAttributes         = USB_CONFIG_ATTR_MUST_SET | USB_DEVICE_ATTR,
+  .conf.bMaxPower            = USB_CONFIG_MAX_POWER(USB_DEVICE_POWER),
+  .cdcIad0                   = UDI_CDC_IAD_DESC_0,
+  .cdcComm0                  = UDI_CDC_COMM_DESC_0,
+  .cdcData0                  = UDI_CDC_DATA_DESC_0_FS,
+  .cdcIad1                   = UDI_CDC_IAD_DESC_1,
+  .cdcComm1                  = UDI_CDC_COMM_DESC_1,
+  .cdcData1                  = UDI_CDC_DATA_DESC_1_FS,
+  .vendor                    = VENDOR_DESC(VENDOR_EP_SIZE_FS),
+};
+
+#ifdef USB_DEVICE_HS_SUPPORT
+/** \brief USB configuration descriptor for high speed */
+COMPILER_WORD_ALIGNED
+UDC_DESC_STORAGE udc_desc_t udc_desc_hs =
+{
+  .conf.bLength              = sizeof(usb_conf_desc_t),
+  .conf.bDescriptorType      = USB_DT_CONFIGURATION,
+  .conf.wTotalLength         = LE16(sizeof(udc_desc_t)),
+  .conf.bNumInterfaces       = USB_DEVICE_NB_INTERFACE,
+  .conf.bConfigurationValue  = 1,
+  .conf.iConfiguration       = 0,
+  .conf.bmAttributes         = USB_CONFIG_ATTR_MUST_SET | USB_DEVICE_ATTR,
+  .conf.bMaxPower            = USB_CONFIG_MAX_POWER(USB_DEVICE_POWER),
+  .cdcIad0                   = UDI_CDC_IAD_DESC_0,
+  .cdcComm0                  = UDI_CDC_COMM_DESC_0,
+  .cdcData0                  = UDI_CDC_DATA_DESC_0_HS,
+  .cdcIad1                   = UDI_CDC_IAD_DESC_1,
+  .cdcComm1                  = UDI_CDC_COMM_DESC_1,
+  .cdcData1                  = UDI_CDC_DATA_DESC_1_HS,
+  .vendor                    = VENDOR_DESC(VENDOR_EP_SIZE_HS),
+};
+#endif
+
+/** \brief Interface functions of every interface, in interface number order */
+UDC_DESC_STORAGE udi_api_t *udi_apis[USB_DEVICE_NB_INTERFACE] =
+{
+  &udi_api_cdc_comm,
+  &udi_api_cdc_data,
+  &udi_api_cdc_comm,
+  &udi_api_cdc_data,
+  &udi_api_vendor,
+};
+
+/** \brief Full speed configuration */
+UDC_DESC_STORAGE udc_config_speed_t udc_config_fs[1] =
+{
+  {
+    .desc                    = (usb_conf_desc_t UDC_DESC_STORAGE*)&udc_desc_fs,
+    .udi_apis                = udi_apis,
+  }
+};
+
+#ifdef USB_DEVICE_HS_SUPPORT
+/** \brief High speed configuration */
+UDC_DESC_STORAGE udc_config_speed_t udc_config_hs[1] =
+{
+  {
+    .desc                    = (usb_conf_desc_t UDC_DESC_STORAGE*)&udc_desc_hs,
+    .udi_apis                = udi_apis,
+  }
+};
+#endif
+
+/** \brief All descriptors of the device, used by USB device stack */
+UDC_DESC_STORAGE udc_config_t udc_config =
+{
+  .confdev_lsfs              = &udc_device_desc,
+  .conf_lsfs                 = udc_config_fs,
+#ifdef USB_DEVICE_HS_SUPPORT
+  .confdev_hs                = &udc_device_desc,
+  .qualifier                 = &udc_device_qual,
+  .conf_hs                   = udc_config_hs,
+#endif
+  .conf_bos                  = NULL,
+};
+
+
+/******************************* end of usbDescriptors.c *******************************/
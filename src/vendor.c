@@ -0,0 +1,446 @@
+/************************************************************************************//**
+* \file     vendor.c
+* \brief    This module implements vendor specific bulk streaming interface.
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include <string.h>                  /* Memory functions                               */
+#include "vendor.h"                  /* Vendor bulk streaming interface                */
+#include "event.h"                   /* Event queues                                   */
+#include "status.h"                  /* Health and throughput counters                 */
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+bool vendorEnable(void);
+void vendorDisable(void);
+bool vendorSetup(void);
+uint8_t vendorGetSetting(void);
+void vendorSofNotify(void);
+uint8_t vendorAvailable(void);
+uint8_t vendorRead(void);
+uint8_t vendorWrite(uint8_t *payload);
+uint8_t vendorPrintBuf(uint8_t *bufPtr, uint16_t len);
+uint16_t vendorTxFree(void);
+uint8_t vendorSubmit(uint8_t *bufPtr, uint16_t len, com_done_t done);
+void vendorOpen(void);
+void vendorRun(void);
+void vendorSent(udd_ep_status_t status, iram_size_t nb_transfered, udd_ep_id_t ep);
+
+
+/****************************************************************************************
+* Global data declarations
+****************************************************************************************/
+/** \brief Interface functions called by USB device stack */
+UDC_DESC_STORAGE udi_api_t udi_api_vendor =
+{
+  vendorEnable,
+  vendorDisable,
+  vendorSetup,
+  vendorGetSetting,
+  vendorSofNotify,
+};
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+/** \brief Comunication interface structure of the bulk interface */
+static COM_t vendorInterface =
+{
+  NULL,
+  vendorAvailable,
+  vendorRead,
+  vendorWrite,
+  vendorPrintBuf,
+  vendorTxFree,
+  vendorSubmit,
+};
+/** \brief Transmit buffers, endpoint sends them in order. */
+COMPILER_WORD_ALIGNED
+static uint8_t vendorBuf[VENDOR_BUFFERS][VENDOR_BUFFER_SIZE];
+/** \brief Number of bytes in every transmit buffer. */
+static uint16_t vendorFill[VENDOR_BUFFERS];
+/** \brief Buffer of the caller sent instead of transmit buffer, NULL if none. */
+static uint8_t *vendorExt[VENDOR_BUFFERS];
+/** \brief Called when buffer of the caller was sent. */
+static com_done_t vendorDone[VENDOR_BUFFERS];
+/** \brief Total number of buffers closed for sending. */
+static volatile uint32_t vendorTail = 0;
+/** \brief Total number of buffers sent, buffer being filled is at tail. */
+static volatile uint32_t vendorHead = 0;
+/** \brief Indicates transfer is running on the endpoint. */
+static volatile bool vendorBusy = false;
+/** \brief Indicates host selected configuration with the interface. */
+static volatile bool vendorEnabled = false;
+/** \brief Time data waits in buffer being filled before it is sent, in ms. */
+static uint16_t vendorLatency = VENDOR_LATENCY;
+/** \brief Time the oldest data waits in buffer being filled, in ms. */
+static uint16_t vendorAge = 0;
+
+
+/****************************************************************************************
+*                           V E N D O R   I N T E R F A C E
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Obtains a pointer to the bulk interface structure.
+** \return    Pointer to interface structure.
+**
+****************************************************************************************/
+COM_t *vendorGetComInterface(void)
+{
+  return &vendorInterface;
+} /*** end of vendorGetComInterface ***/
+
+/************************************************************************************//**
+** \brief     Sets time data waits in transmit buffer for more data. Frames written
+**            within this time are sent together in transfers of whole packets, a
+**            buffer which is not full is sent once its oldest data is this old.
+** \param     ms Latency in ms, up to VENDOR_LATENCY_MAX. 0 and 1 send on next frame.
+**
+****************************************************************************************/
+void vendorSetLatency(uint16_t ms)
+{
+  vendorLatency = (ms > VENDOR_LATENCY_MAX) ? VENDOR_LATENCY_MAX : ms;
+} /*** end of vendorSetLatency ***/
+
+/************************************************************************************//**
+** \brief     Called by USB device stack when configuration is selected. Endpoint is
+**            already allocated, transmit buffers start empty.
+** \return    True.
+**
+****************************************************************************************/
+bool vendorEnable(void)
+{
+  uint32_t flags = eventLock();
+
+  vendorTail = 0;
+  vendorHead = 0;
+  vendorOpen();
+  vendorBusy = false;
+  vendorEnabled = true;
+  eventUnlock(flags);
+  return true;
+} /*** end of vendorEnable ***/
+
+/************************************************************************************//**
+** \brief     Called by USB device stack on reset or when device is detached.
+**
+****************************************************************************************/
+void vendorDisable(void)
+{
+  vendorEnabled = false;
+} /*** end of vendorDisable ***/
+
+/************************************************************************************//**
+** \brief     Called by USB device stack for requests to the interface, there are none.
+** \return    False, request is stalled.
+**
+****************************************************************************************/
+bool vendorSetup(void)
+{
+  return false;
+} /*** end of vendorSetup ***/
+
+/************************************************************************************//**
+** \brief     Obtains alternate setting of the interface.
+** \return    0, there is only one.
+**
+****************************************************************************************/
+uint8_t vendorGetSetting(void)
+{
+  return 0;
+} /*** end of vendorGetSetting ***/
+
+/************************************************************************************//**
+** \brief     Called by USB device stack every 1 ms. Buffer which is not full is sent
+**            once its data waited for latency time and the endpoint is idle.
+**
+****************************************************************************************/
+void vendorSofNotify(void)
+{
+  uint32_t flags = eventLock();
+
+  if(vendorEnabled && (vendorTail - vendorHead < VENDOR_BUFFERS) &&
+     vendorFill[vendorTail % VENDOR_BUFFERS])
+  {
+    if(vendorAge < vendorLatency)
+    {
+      vendorAge++;
+    }
+    if(!vendorBusy && (vendorTail == vendorHead) && (vendorAge >= vendorLatency))
+    {
+      vendorTail++;
+      vendorOpen();
+      vendorRun();
+    }
+  }
+  eventUnlock(flags);
+} /*** end of vendorSofNotify ***/
+
+/************************************************************************************//**
+** \brief     Return length of data in receive buffer, interface only sends.
+** \return    0.
+**
+****************************************************************************************/
+uint8_t vendorAvailable(void)
+{
+  return 0;
+} /*** end of vendorAvailable ***/
+
+/************************************************************************************//**
+** \brief     Return char from receive buffer, interface only sends.
+** \return    0.
+**
+****************************************************************************************/
+uint8_t vendorRead(void)
+{
+  return 0;
+} /*** end of vendorRead ***/
+
+/************************************************************************************//**
+** \brief     Write single char to interface.
+** \return    Return result.
+**
+****************************************************************************************/
+uint8_t vendorWrite(uint8_t *payload)
+{
+  return vendorPrintBuf(payload, 1);
+} /*** end of vendorWrite ***/
+
+/************************************************************************************//**
+** \brief     Copies buffer to transmit buffers. Every full transmit buffer is closed
+**            and sent as one transfer of many packets. Data which does not fit is
+**            dropped, see vendorTxFree(). Data is dropped while host has not selected
+**            configuration, so acquisition never waits for a missing host.
+** \param     bufPtr Data.
+** \param     len Number of bytes.
+** \return    1 if all data was written, 0 otherwise.
+**
+****************************************************************************************/
+uint8_t vendorPrintBuf(uint8_t *bufPtr, uint16_t len)
+{
+  uint32_t flags = eventLock();
+  uint16_t *fill;
+  uint16_t part;
+
+  if(!vendorEnabled)
+  {
+    eventUnlock(flags);
+    return 0;
+  }
+  while(len)
+  {
+    /* All buffers are closed, the one at tail belongs to the endpoint. */
+    if(vendorTail - vendorHead >= VENDOR_BUFFERS)
+    {
+      break;
+    }
+    fill = &vendorFill[vendorTail % VENDOR_BUFFERS];
+    part = VENDOR_BUFFER_SIZE - *fill;
+    if(part > len)
+    {
+      part = len;
+    }
+    memcpy(&vendorBuf[vendorTail % VENDOR_BUFFERS][*fill], bufPtr, part);
+    *fill += part;
+    bufPtr += part;
+    len -= part;
+    if(*fill == VENDOR_BUFFER_SIZE)
+    {
+      vendorTail++;
+      if(vendorTail - vendorHead < VENDOR_BUFFERS)
+      {
+        vendorOpen();
+      }
+      vendorRun();
+    }
+  }
+  eventUnlock(flags);
+  return len ? 0 : 1;
+} /*** end of vendorPrintBuf ***/
+
+/************************************************************************************//**
+** \brief     Return free space in transmit buffers.
+** \return    Number of bytes which can be written without waiting.
+**
+****************************************************************************************/
+uint16_t vendorTxFree(void)
+{
+  uint32_t flags = eventLock();
+  uint32_t room = 0;
+
+  /* Host is missing, data is dropped anyway. */
+  if(!vendorEnabled)
+  {
+    room = VENDOR_BUFFER_SIZE;
+  }
+  else if(vendorTail - vendorHead < VENDOR_BUFFERS)
+  {
+    room = VENDOR_BUFFER_SIZE - vendorFill[vendorTail % VENDOR_BUFFERS];
+    room += (VENDOR_BUFFERS - 1 - (vendorTail - vendorHead)) * VENDOR_BUFFER_SIZE;
+  }
+  eventUnlock(flags);
+  /* Arbiter writes are limited to 16 bits. */
+  return (room > 0xFFFF) ? 0xFFFF : (uint16_t)room;
+} /*** end of vendorTxFree ***/
+
+/************************************************************************************//**
+** \brief     Sends buffer of the caller without copying it. Data written before is
+**            sent first, the endpoint reads buffer straight to its FIFO. Buffer must
+**            stay unchanged until done callback is called. Small buffers are copied
+**            to transmit buffer instead and released right away. While host has not
+**            selected configuration, buffer is dropped and released right away.
+** \param     bufPtr Data.
+** \param     len Number of bytes.
+** \param     done Called with bufPtr and len when buffer was sent or dropped, may be
+**            NULL.
+** \return    1 if buffer was taken, 0 if all transmit buffers are in use.
+**
+****************************************************************************************/
+uint8_t vendorSubmit(uint8_t *bufPtr, uint16_t len, com_done_t done)
+{
+  uint32_t flags = eventLock();
+  uint8_t idx;
+
+  if(!vendorEnabled)
+  {
+    eventUnlock(flags);
+    if(done != NULL)
+    {
+      done(bufPtr, len);
+    }
+    return 1;
+  }
+  /* Small frame is coalesced with data around it into whole packets. */
+  if(len <= VENDOR_COPY_MAX)
+  {
+    eventUnlock(flags);
+    if((vendorTxFree() < len) || !vendorPrintBuf(bufPtr, len))
+    {
+      return 0;
+    }
+    if(done != NULL)
+    {
+      done(bufPtr, len);
+    }
+    return 1;
+  }
+  /* Buffer being filled is closed first, so one more is needed then. */
+  if(VENDOR_BUFFERS - (vendorTail - vendorHead) <
+     (vendorFill[vendorTail % VENDOR_BUFFERS] ? 2u : 1u))
+  {
+    eventUnlock(flags);
+    return 0;
+  }
+  if(vendorFill[vendorTail % VENDOR_BUFFERS])
+  {
+    vendorTail++;
+  }
+  idx = vendorTail % VENDOR_BUFFERS;
+  vendorExt[idx] = bufPtr;
+  vendorFill[idx] = len;
+  vendorDone[idx] = done;
+  vendorTail++;
+  if(vendorTail - vendorHead < VENDOR_BUFFERS)
+  {
+    vendorOpen();
+  }
+  vendorRun();
+  eventUnlock(flags);
+  return 1;
+} /*** end of vendorSubmit ***/
+
+/************************************************************************************//**
+** \brief     Empties transmit buffer at tail, data is written to it from now on.
+**
+****************************************************************************************/
+void vendorOpen(void)
+{
+  uint8_t idx = vendorTail % VENDOR_BUFFERS;
+
+  vendorFill[idx] = 0;
+  vendorExt[idx] = NULL;
+  vendorDone[idx] = NULL;
+  vendorAge = 0;
+} /*** end of vendorOpen ***/
+
+/************************************************************************************//**
+** \brief     Starts transfer of the oldest closed buffer if the endpoint is idle. Full
+**            buffer is sent in whole packets only, host request continues with next
+**            buffer. Any other ends with a short packet, so host gets it right away.
+**
+****************************************************************************************/
+void vendorRun(void)
+{
+  uint8_t idx = vendorHead % VENDOR_BUFFERS;
+  uint8_t *buf = vendorExt[idx] ? vendorExt[idx] : vendorBuf[idx];
+  bool shortPacket = vendorExt[idx] || (vendorFill[idx] != VENDOR_BUFFER_SIZE);
+
+  if(vendorBusy || (vendorHead == vendorTail))
+  {
+    return;
+  }
+  vendorBusy = udd_ep_run(VENDOR_EP_IN, shortPacket, buf, vendorFill[idx], vendorSent);
+} /*** end of vendorRun ***/
+
+
+/****************************************************************************************
+*                        C A L L B A C K   F U N C T I O N S
+****************************************************************************************/
+/************************************************************************************//**
+** \brief     Called by USB device stack when transfer of a buffer is complete. The next
+**            closed buffer is started right away, before new data is requested. When
+**            transfer was aborted, buffers of callers are released and data is dropped.
+** \param     status UDD_EP_TRANSFER_OK or UDD_EP_TRANSFER_ABORT.
+** \param     nb_transfered Number of sent bytes.
+** \param     ep Endpoint.
+**
+****************************************************************************************/
+void vendorSent(udd_ep_status_t status, iram_size_t nb_transfered, udd_ep_id_t ep)
+{
+  uint8_t idx = vendorHead % VENDOR_BUFFERS;
+  com_done_t done = vendorDone[idx];
+  uint8_t *ext = vendorExt[idx];
+  uint16_t len = vendorFill[idx];
+
+  vendorBusy = false;
+  if(status != UDD_EP_TRANSFER_OK)
+  {
+    statusCount(STATUS_TX_ABORTS);
+    for(uint32_t i = vendorHead; i != vendorTail; i++)
+    {
+      idx = i % VENDOR_BUFFERS;
+      if(vendorDone[idx] != NULL)
+      {
+        vendorDone[idx](vendorExt[idx], vendorFill[idx]);
+      }
+    }
+    vendorHead = vendorTail;
+    vendorOpen();
+    return;
+  }
+  /* Buffer at tail is reopened if all of them were closed. */
+  if(vendorTail - vendorHead >= VENDOR_BUFFERS)
+  {
+    vendorOpen();
+  }
+  vendorHead++;
+  vendorRun();
+  if(done != NULL)
+  {
+    done(ext, len);
+  }
+  /* Only continue if callback function was linked. */
+  if(vendorInterface.txEmptyCallback != NULL)
+  {
+    vendorInterface.txEmptyCallback();
+  }
+} /*** end of vendorSent ***/
+
+
+/*********************************** end of vendor.c ***********************************/
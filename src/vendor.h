@@ -0,0 +1,87 @@
+/************************************************************************************//**
+* \file     vendor.h
+* \brief    This module implements vendor specific bulk streaming interface.
+****************************************************************************************/
+#ifndef VENDOR_H_
+#define VENDOR_H_
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <asf.h>                     /* Atmel Software Framework include file          */
+#include "comInterface.h"            /* USB interface driver                           */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Interface number, follows the two interfaces of each CDC port */
+#define VENDOR_IFACE_NUMBER 4
+/** \brief Bulk IN endpoint, dual bank endpoint of the UDP after those of CDC ports */
+#define VENDOR_EP_IN        (7 | USB_EP_DIR_IN)
+/** \brief Bulk packet size at full speed */
+#define VENDOR_EP_SIZE_FS   64
+/** \brief Bulk packet size at high speed */
+#define VENDOR_EP_SIZE_HS   512
+/** \brief Number of transmit buffers, one is sent while the others are filled */
+#define VENDOR_BUFFERS      4
+/** \brief Size of transmit buffer, multiple of packet size */
+#define VENDOR_BUFFER_SIZE  1024
+/** \brief Buffers given by reference up to this size are copied and coalesced with
+ *         other data, so small frames do not end up in short packets.
+ */
+#define VENDOR_COPY_MAX     VENDOR_EP_SIZE_HS
+/** \brief Default time data waits for more to fill transmit buffer, in ms */
+#define VENDOR_LATENCY      1
+/** \brief Longest time data waits for more to fill transmit buffer, in ms */
+#define VENDOR_LATENCY_MAX  1000
+
+/** \brief Content of interface and endpoint descriptor */
+#define VENDOR_DESC(epSize) { \
+   .iface.bLength             = sizeof(usb_iface_desc_t),\
+   .iface.bDescriptorType     = USB_DT_INTERFACE,\
+   .iface.bInterfaceNumber    = VENDOR_IFACE_NUMBER,\
+   .iface.bAlternateSetting   = 0,\
+   .iface.bNumEndpoints       = 1,\
+   .iface.bInterfaceClass     = CLASS_VENDOR_SPECIFIC,\
+   .iface.bInterfaceSubClass  = NO_SUBCLASS,\
+   .iface.bInterfaceProtocol  = NO_PROTOCOL,\
+   .iface.iInterface          = 0,\
+   .epIn.bLength              = sizeof(usb_ep_desc_t),\
+   .epIn.bDescriptorType      = USB_DT_ENDPOINT,\
+   .epIn.bEndpointAddress     = VENDOR_EP_IN,\
+   .epIn.bmAttributes         = USB_EP_TYPE_BULK,\
+   .epIn.wMaxPacketSize       = LE16(epSize),\
+   .epIn.bInterval            = 0,\
+   }
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+/** \brief Interface descriptor with its bulk IN endpoint */
+COMPILER_PACK_SET(1)
+typedef struct
+{
+  usb_iface_desc_t iface;            /* Interface descriptor                           */
+  usb_ep_desc_t epIn;                /* Bulk IN endpoint descriptor                    */
+}udi_vendor_desc_t;
+COMPILER_PACK_RESET()
+
+
+/***************************************************************************************
+* Global data declarations
+****************************************************************************************/
+extern UDC_DESC_STORAGE udi_api_t udi_api_vendor;
+
+
+/***************************************************************************************
+* Function prototypes
+****************************************************************************************/
+COM_t *vendorGetComInterface(void);
+void vendorSetLatency(uint16_t ms);
+
+
+#endif /* VENDOR_H_ */
+/*********************************** end of vendor.h ***********************************/